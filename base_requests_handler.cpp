@@ -0,0 +1,308 @@
+#include "base_requests_handler.h"
+#include "json_reader.h"
+
+#include <algorithm>
+
+using namespace std::literals;
+
+
+BaseRequestsHandler::BaseRequestsHandler(std::vector<transport_catalogue::StopWithDistances>& stops,
+                                         std::vector<transport_catalogue::BusWithStopNames>& buses)
+        : stops_(stops)
+        , buses_(buses) {
+}
+
+BaseRequestsHandler::Field BaseRequestsHandler::FieldOf(std::string_view key) {
+    if (key == "type"sv) return TYPE;
+    if (key == "name"sv) return NAME;
+    if (key == "latitude"sv) return LATITUDE;
+    if (key == "longitude"sv) return LONGITUDE;
+    if (key == "road_distances"sv) return ROAD_DISTANCES;
+    if (key == "is_roundtrip"sv) return IS_ROUNDTRIP;
+    if (key == "stops"sv) return STOPS;
+    return OTHER;
+}
+
+uint32_t BaseRequestsHandler::Bit(Field field) {
+    return uint32_t{1} << field;
+}
+
+void BaseRequestsHandler::StartNested(bool build) {
+    nested_depth_ = depth_ + 1;
+    if (build) {
+        section_.emplace();
+    } else {
+        section_.reset();
+    }
+}
+
+void BaseRequestsHandler::StartDict() {
+    if (nested_depth_ == 0) {
+        switch (depth_) {
+            case 0:
+                root_is_dict_ = true;
+                break;
+            case 1:
+                if (key_ == BASE_DATA) {
+                    base_seen_ = true;
+                    StartNested(false);
+                } else {
+                    StartNested(true);
+                }
+                break;
+            case 2:
+                entry_ = PendingEntry{};
+                ++entries_count_;
+                break;
+            case 3:
+                if (field_ == ROAD_DISTANCES) {
+                    entry_.valid |= Bit(ROAD_DISTANCES);
+                } else {
+                    StartNested(false);
+                }
+                break;
+            default:
+                // a container inside road_distances or stops
+                entry_.valid &= ~Bit(field_);
+                StartNested(false);
+        }
+    }
+    if (section_) {
+        section_->StartDict();
+    }
+    ++depth_;
+}
+
+void BaseRequestsHandler::Key(std::string&& key) {
+    if (section_) {
+        section_->Key(std::move(key));
+        return;
+    }
+    if (nested_depth_ != 0) return;
+
+    switch (depth_) {
+        case 1:
+            ++root_size_;
+            key_ = std::move(key);
+            break;
+        case 3:
+            field_ = FieldOf(key);
+            if (field_ != OTHER) {
+                if ((entry_.seen & Bit(field_)) != 0) {
+                    field_ = OTHER;
+                } else {
+                    entry_.seen |= Bit(field_);
+                }
+            }
+            break;
+        default:
+            // a stop name in road_distances
+            key_ = std::move(key);
+    }
+}
+
+void BaseRequestsHandler::EndDict() {
+    --depth_;
+    if (nested_depth_ != 0) {
+        if (section_) {
+            section_->EndDict();
+        }
+        if (depth_ < nested_depth_) {
+            if (section_) {
+                sections_.emplace(std::move(key_), section_->Build());
+                section_.reset();
+            }
+            nested_depth_ = 0;
+        }
+        return;
+    }
+    if (depth_ == 2) {
+        FinishEntry();
+    }
+}
+
+void BaseRequestsHandler::StartArray() {
+    if (nested_depth_ == 0) {
+        switch (depth_) {
+            case 0:
+                StartNested(false);
+                break;
+            case 1:
+                if (key_ == BASE_DATA) {
+                    if (!base_seen_) {
+                        base_seen_ = true;
+                        base_is_array_ = true;
+                    } else {
+                        StartNested(false);
+                    }
+                } else {
+                    StartNested(true);
+                }
+                break;
+            case 2:
+                ++entries_count_;
+                bad_entries_ = true;
+                StartNested(false);
+                break;
+            case 3:
+                if (field_ == STOPS) {
+                    entry_.valid |= Bit(STOPS);
+                } else {
+                    StartNested(false);
+                }
+                break;
+            default:
+                entry_.valid &= ~Bit(field_);
+                StartNested(false);
+        }
+    }
+    if (section_) {
+        section_->StartArray();
+    }
+    ++depth_;
+}
+
+void BaseRequestsHandler::EndArray() {
+    --depth_;
+    if (nested_depth_ != 0) {
+        if (section_) {
+            section_->EndArray();
+        }
+        if (depth_ < nested_depth_) {
+            if (section_) {
+                sections_.emplace(std::move(key_), section_->Build());
+                section_.reset();
+            }
+            nested_depth_ = 0;
+        }
+    }
+}
+
+void BaseRequestsHandler::Value(json::Node&& value) {
+    if (section_) {
+        section_->Value(std::move(value));
+        return;
+    }
+    if (nested_depth_ != 0) return;
+
+    switch (depth_) {
+        case 0:
+            break;
+        case 1:
+            if (key_ == BASE_DATA) {
+                base_seen_ = true;
+            } else {
+                sections_.emplace(std::move(key_), std::move(value));
+            }
+            break;
+        case 2:
+            ++entries_count_;
+            bad_entries_ = true;
+            break;
+        case 3:
+            SetField(std::move(value));
+            break;
+        default:
+            if (field_ == ROAD_DISTANCES && value.IsInt()) {
+                entry_.distances.push_back({std::move(key_), static_cast<size_t>(value.AsInt())});
+            } else if (field_ == STOPS && value.IsString()) {
+                entry_.stops.emplace_back(value.AsString());
+            } else {
+                entry_.valid &= ~Bit(field_);
+            }
+    }
+}
+
+void BaseRequestsHandler::SetField(json::Node&& value) {
+    switch (field_) {
+        case TYPE:
+            if (value.IsString()) {
+                entry_.type = value.AsString();
+                entry_.valid |= Bit(TYPE);
+            }
+            break;
+        case NAME:
+            if (value.IsString()) {
+                entry_.name = value.AsString();
+                entry_.valid |= Bit(NAME);
+            }
+            break;
+        case LATITUDE:
+            if (value.IsDouble()) {
+                entry_.coordinates.lat = value.AsDouble();
+                entry_.valid |= Bit(LATITUDE);
+            }
+            break;
+        case LONGITUDE:
+            if (value.IsDouble()) {
+                entry_.coordinates.lng = value.AsDouble();
+                entry_.valid |= Bit(LONGITUDE);
+            }
+            break;
+        case IS_ROUNDTRIP:
+            if (value.IsBool()) {
+                entry_.is_roundtrip = value.AsBool();
+                entry_.valid |= Bit(IS_ROUNDTRIP);
+            }
+            break;
+        default:
+            // road_distances and stops must be containers, other fields are not used
+            break;
+    }
+}
+
+void BaseRequestsHandler::FinishEntry() {
+    using namespace transport_catalogue;
+
+    const auto has = [this](Field field) {
+        return (entry_.valid & Bit(field)) != 0;
+    };
+    const bool distances_ok = has(ROAD_DISTANCES) || (entry_.seen & Bit(ROAD_DISTANCES)) == 0;
+
+    if (has(TYPE) && entry_.type == "Stop"sv && has(NAME) && has(LATITUDE) && has(LONGITUDE) && distances_ok) {
+        // the same order as json::Dict gives, the first of repeated stops wins
+        auto& distances = entry_.distances;
+        std::stable_sort(distances.begin(), distances.end(), [](const StopDistanceData& lhs, const StopDistanceData& rhs) {
+            return lhs.other_stop_name < rhs.other_stop_name;
+        });
+        distances.erase(std::unique(distances.begin(), distances.end(), [](const StopDistanceData& lhs, const StopDistanceData& rhs) {
+            return lhs.other_stop_name == rhs.other_stop_name;
+        }), distances.end());
+
+        StopWithDistances stop;
+        stop.id = 0;
+        stop.stop_name = std::move(entry_.name);
+        stop.coordinates = entry_.coordinates;
+        stop.distances = std::move(distances);
+        stops_.push_back(std::move(stop));
+    } else if (has(TYPE) && entry_.type == "Bus"sv && has(NAME) && has(IS_ROUNDTRIP) && has(STOPS)) {
+        buses_.push_back({std::move(entry_.name), entry_.is_roundtrip ? RouteType::CIRCLE_ROUTE : RouteType::RETURN_ROUTE,
+                          std::move(entry_.stops)});
+    } else {
+        bad_entries_ = true;
+    }
+}
+
+bool BaseRequestsHandler::IsRootDict() const {
+    return root_is_dict_;
+}
+
+size_t BaseRequestsHandler::GetRootSize() const {
+    return root_size_;
+}
+
+bool BaseRequestsHandler::HasBaseRequests() const {
+    return base_is_array_;
+}
+
+size_t BaseRequestsHandler::GetEntriesCount() const {
+    return entries_count_;
+}
+
+bool BaseRequestsHandler::HasBadEntries() const {
+    return bad_entries_;
+}
+
+json::Dict BaseRequestsHandler::TakeOtherSections() {
+    return std::move(sections_);
+}
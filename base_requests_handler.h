@@ -0,0 +1,89 @@
+#pragma once
+
+#include "domain.h"
+#include "json.h"
+#include "json_builder.h"
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+
+// Reads a make_base document without building its tree. Entries of "base_requests" go straight
+// into the vectors for TransportCatalogue::BulkLoad, the other sections of the root are built as
+// usual. Entries are checked the same way as JsonReader::ParseDataNode() does it.
+class BaseRequestsHandler final : public json::Handler {
+public:
+    BaseRequestsHandler(std::vector<transport_catalogue::StopWithDistances>& stops,
+                        std::vector<transport_catalogue::BusWithStopNames>& buses);
+
+    void StartDict() override;
+    void Key(std::string&& key) override;
+    void EndDict() override;
+    void StartArray() override;
+    void EndArray() override;
+    void Value(json::Node&& value) override;
+
+    bool IsRootDict() const;
+    // number of keys of the root, base_requests included
+    size_t GetRootSize() const;
+    bool HasBaseRequests() const;
+    size_t GetEntriesCount() const;
+    bool HasBadEntries() const;
+    // the root without base_requests
+    json::Dict TakeOtherSections();
+
+private:
+    enum Field : uint32_t {
+        TYPE,
+        NAME,
+        LATITUDE,
+        LONGITUDE,
+        ROAD_DISTANCES,
+        IS_ROUNDTRIP,
+        STOPS,
+        OTHER,
+    };
+
+    // an entry of base_requests while it is read, the type may come last
+    struct PendingEntry {
+        uint32_t seen = 0; // bits of fields met, a repeated field is ignored as in json::Dict
+        uint32_t valid = 0; // bits of fields with a value of the right type
+        std::string type;
+        std::string name;
+        geo::Coordinates coordinates;
+        std::vector<transport_catalogue::StopDistanceData> distances;
+        bool is_roundtrip = false;
+        std::vector<std::string> stops;
+    };
+
+    std::vector<transport_catalogue::StopWithDistances>& stops_;
+    std::vector<transport_catalogue::BusWithStopNames>& buses_;
+
+    // depth 1 is the root, 2 is base_requests, 3 is an entry, 4 is its road_distances or stops
+    size_t depth_ = 0;
+    // a value below the known levels is being built into section_ or skipped, until the depth
+    // drops below nested_depth_
+    size_t nested_depth_ = 0;
+    std::optional<json::Builder> section_;
+
+    bool root_is_dict_ = false;
+    size_t root_size_ = 0;
+    bool base_seen_ = false;
+    bool base_is_array_ = false;
+    size_t entries_count_ = 0;
+    bool bad_entries_ = false;
+
+    std::string key_;
+    Field field_ = OTHER;
+    PendingEntry entry_;
+    json::Dict sections_;
+
+    static Field FieldOf(std::string_view key);
+    static uint32_t Bit(Field field);
+
+    void StartNested(bool build);
+    void SetField(json::Node&& value);
+    void FinishEntry();
+};
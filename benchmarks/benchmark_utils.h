@@ -0,0 +1,47 @@
+#pragma once
+
+#include "transport_catalogue.h"
+#include "json_reader.h"
+#include "catalogue_snapshot.h"
+
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+
+// Helpers shared by the benchmarks. Their numbers mean something in a Release build only.
+namespace benchmark {
+
+    // the largest base of the tests, TC_SOURCE_DIR is set by CMake
+    inline std::string DefaultMakeBase() {
+        return std::string(TC_SOURCE_DIR) + "/tests/s14_3_opentest_3_make_base.json";
+    }
+
+    // an empty argument keeps the default too, so later arguments can be given alone
+    inline std::string ArgOr(int argc, char** argv, int index, std::string value) {
+        return index < argc && argv[index][0] != '\0' ? std::string(argv[index]) : value;
+    }
+
+    inline double SecondsSince(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    // Reads a make_base document into a version that owns its catalogue
+    inline std::shared_ptr<CatalogueVersion> LoadMakeBase(const std::string& file) {
+        std::ifstream input(file);
+        if (!input) {
+            throw std::runtime_error("Cannot open " + file);
+        }
+
+        auto catalogue = std::make_shared<transport_catalogue::TransportCatalogue>();
+        JsonReader reader(*catalogue);
+        reader.ReadJsonToTransportCatalogue(input);
+        auto version = reader.MakeCatalogueVersion();
+        version->catalogue = std::move(catalogue);
+
+        return version;
+    }
+
+}  // namespace benchmark
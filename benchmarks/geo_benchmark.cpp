@@ -0,0 +1,75 @@
+// Distances per second of the batch haversine kernels against the acos formula.
+// Usage: geo_benchmark [points]; the numbers mean something in a Release build only.
+
+#include "geo.h"
+#include "cpu_features.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace std::literals;
+
+namespace {
+
+const int ROUNDS = 20;
+
+template <typename Kernel>
+void Measure(std::string_view name, size_t count, Kernel&& kernel) {
+    kernel(); // warms up the caches
+    const auto start = std::chrono::steady_clock::now();
+    for (int round = 0; round < ROUNDS; ++round) {
+        kernel();
+    }
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    const double per_second = static_cast<double>(count) * ROUNDS / elapsed.count();
+    std::cout << name << ": "sv << per_second / 1e6 << " M distances/s"sv << std::endl;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    const size_t count = argc > 1 ? std::stoul(argv[1]) : 100000;
+
+    std::mt19937_64 random(42);
+    std::uniform_real_distribution<double> lat(43.5, 43.7);
+    std::uniform_real_distribution<double> lng(39.6, 39.9);
+    std::vector<geo::Coordinates> from, to;
+    std::vector<geo::CoordinatesTrig> from_trig, to_trig;
+    for (size_t i = 0; i < count; ++i) {
+        from.push_back({lat(random), lng(random)});
+        to.push_back({lat(random), lng(random)});
+        from_trig.push_back(geo::ComputeTrig(from.back()));
+        to_trig.push_back(geo::ComputeTrig(to.back()));
+    }
+
+    std::cout << count << " pairs, AVX2 "sv << (cpu::HasAvx2() ? "on"sv : "not supported"sv) << std::endl;
+
+    std::vector<double> result(count);
+    double sink = 0.0;
+    Measure("acos ComputeDistance"sv, count, [&]() {
+        for (size_t i = 0; i < count; ++i) {
+            result[i] = geo::ComputeDistance(from[i], to[i]);
+        }
+        sink += result[0];
+    });
+    Measure("ComputeDistancesScalar"sv, count, [&]() {
+        geo::ComputeDistancesScalar(from_trig.data(), to_trig.data(), count, result.data());
+        sink += result[0];
+    });
+    Measure("ComputeDistances"sv, count, [&]() {
+        geo::ComputeDistances(from_trig.data(), to_trig.data(), count, result.data());
+        sink += result[0];
+    });
+    Measure("ComputeDistancesFrom"sv, count, [&]() {
+        geo::ComputeDistancesFrom(from_trig[0], to_trig.data(), count, result.data());
+        sink += result[0];
+    });
+
+    // keeps the results alive for the optimizer
+    return sink < 0.0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,111 @@
+// Scaling of CatalogueIngestor with the number of producer threads, against one thread
+// handing the same data to BulkLoad directly. The data is synthetic: every stop has two
+// distances, every bus goes over ten random stops.
+// Usage: ingestor_benchmark [max_threads] [stops] [buses]
+
+#include "benchmark_utils.h"
+#include "catalogue_ingestor.h"
+
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+using namespace std::literals;
+using namespace transport_catalogue;
+
+namespace {
+
+const size_t DISTANCES_PER_STOP = 2;
+const size_t STOPS_PER_BUS = 10;
+
+struct Data {
+    std::vector<StopWithDistances> stops;
+    std::vector<BusWithStopNames> buses;
+};
+
+Data MakeData(size_t stop_count, size_t bus_count) {
+    std::mt19937 random(1);
+    std::uniform_real_distribution<double> lat(55.0, 56.0);
+    std::uniform_real_distribution<double> lng(37.0, 38.0);
+    std::uniform_int_distribution<size_t> stop_i(0, stop_count - 1);
+    std::uniform_int_distribution<size_t> distance(100, 1100);
+
+    Data data;
+    data.stops.resize(stop_count);
+    for (size_t i = 0; i < stop_count; ++i) {
+        // random prefixes, so the order of names differs from the order of production
+        data.stops[i].stop_name = "stop_"s + std::to_string(random()) + "_"s + std::to_string(i);
+        data.stops[i].coordinates = {lat(random), lng(random)};
+    }
+    for (auto& stop : data.stops) {
+        for (size_t k = 0; k < DISTANCES_PER_STOP; ++k) {
+            stop.distances.push_back({data.stops[stop_i(random)].stop_name, distance(random)});
+        }
+    }
+
+    data.buses.resize(bus_count);
+    for (size_t i = 0; i < bus_count; ++i) {
+        data.buses[i].bus_name = "bus_"s + std::to_string(i);
+        data.buses[i].type = RouteType::RETURN_ROUTE;
+        for (size_t k = 0; k < STOPS_PER_BUS; ++k) {
+            data.buses[i].route_stops.push_back(data.stops[stop_i(random)].stop_name);
+        }
+    }
+    return data;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    const size_t max_threads = std::stoul(benchmark::ArgOr(argc, argv, 1, "16"));
+    const size_t stop_count = std::stoul(benchmark::ArgOr(argc, argv, 2, "400000"));
+    const size_t bus_count = std::stoul(benchmark::ArgOr(argc, argv, 3, "40000"));
+
+    const Data data = MakeData(stop_count, bus_count);
+    std::cout << stop_count << " stops, "sv << stop_count * DISTANCES_PER_STOP << " distances, "sv << bus_count
+              << " buses, "sv << std::thread::hardware_concurrency() << " hardware threads"sv << std::endl;
+
+    {
+        Data copy = data;
+        const auto start = std::chrono::steady_clock::now();
+        TransportCatalogue tc;
+        const size_t rejected = tc.BulkLoad(std::move(copy.stops), std::move(copy.buses));
+        std::cout << "BulkLoad alone: "sv << benchmark::SecondsSince(start) * 1000.0 << " ms, rejected "sv << rejected << std::endl;
+    }
+
+    for (size_t threads = 1; threads <= max_threads; threads *= 2) {
+        Data copy = data;
+        CatalogueIngestor ingestor;
+
+        const auto start = std::chrono::steady_clock::now();
+        std::vector<std::thread> producers;
+        for (size_t producer = 0; producer < threads; ++producer) {
+            producers.emplace_back([&, producer]() {
+                for (size_t i = producer; i < copy.stops.size(); i += threads) {
+                    ingestor.AddStop(std::move(copy.stops[i]));
+                }
+                for (size_t i = producer; i < copy.buses.size(); i += threads) {
+                    ingestor.AddBus(std::move(copy.buses[i]));
+                }
+            });
+        }
+        for (auto& producer : producers) {
+            producer.join();
+        }
+        const double produced = benchmark::SecondsSince(start);
+
+        const auto freeze_start = std::chrono::steady_clock::now();
+        TransportCatalogue tc;
+        const size_t rejected = ingestor.Freeze(tc);
+        const double frozen = benchmark::SecondsSince(freeze_start);
+
+        std::cout << threads << " threads: produce "sv << produced * 1000.0 << " ms, freeze "sv << frozen * 1000.0
+                  << " ms, rejected "sv << rejected << std::endl;
+    }
+
+    return EXIT_SUCCESS;
+}
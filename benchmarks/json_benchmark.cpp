@@ -0,0 +1,86 @@
+// Parsing time of the make_base documents: the old character-by-character istream parser
+// against json::Load from a stream and from a buffer. The trees of all three are compared.
+// Usage: json_benchmark [rounds] [files...], by default tests/*_make_base.json
+
+#include "benchmark_utils.h"
+#include "stream_json_parser.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace std::literals;
+
+namespace {
+
+std::vector<std::string> DefaultFiles() {
+    std::vector<std::string> files;
+    for (const auto& entry : std::filesystem::directory_iterator(std::string(TC_SOURCE_DIR) + "/tests"s)) {
+        const std::string name = entry.path().filename().string();
+        if (name.size() > "_make_base.json"sv.size() && name.substr(name.size() - "_make_base.json"sv.size()) == "_make_base.json"sv) {
+            files.push_back(entry.path().string());
+        }
+    }
+    std::sort(files.begin(), files.end());
+    return files;
+}
+
+std::string ReadFile(const std::string& file) {
+    std::ifstream input(file, std::ios::binary);
+    std::ostringstream text;
+    text << input.rdbuf();
+    return text.str();
+}
+
+// milliseconds per round
+template <typename Parse>
+double Measure(int rounds, Parse&& parse) {
+    const auto start = std::chrono::steady_clock::now();
+    for (int round = 0; round < rounds; ++round) {
+        parse();
+    }
+    return benchmark::SecondsSince(start) * 1000.0 / rounds;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    const int rounds = std::stoi(benchmark::ArgOr(argc, argv, 1, "20"));
+    std::vector<std::string> files(argv + std::min(argc, 2), argv + argc);
+    if (files.empty()) {
+        files = DefaultFiles();
+    }
+
+    bool same = true;
+    for (const std::string& file : files) {
+        const std::string text = ReadFile(file);
+
+        json::Node old_tree;
+        const double old_ms = Measure(rounds, [&]() {
+            std::istringstream input(text);
+            old_tree = stream_json_parser::LoadNode(input);
+        });
+        json::Document stream_doc(nullptr);
+        const double stream_ms = Measure(rounds, [&]() {
+            std::istringstream input(text);
+            stream_doc = json::Load(input);
+        });
+        json::Document buffer_doc(nullptr);
+        const double buffer_ms = Measure(rounds, [&]() {
+            buffer_doc = json::Load(std::string_view(text));
+        });
+
+        const bool file_same = old_tree == stream_doc.GetRoot() && old_tree == buffer_doc.GetRoot();
+        same = same && file_same;
+        std::cout << std::filesystem::path(file).filename().string() << " "sv << text.size() / 1024 << " KB: old istream "sv
+                  << old_ms << " ms, Load(istream) "sv << stream_ms << " ms, Load(buffer) "sv << buffer_ms << " ms"sv
+                  << (file_same ? ""sv : ", TREES DIFFER"sv) << std::endl;
+    }
+
+    return same ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,137 @@
+// Throughput of stat_requests answered by 1, 2, 4 ... threads. The batch is synthetic: Bus, Stop
+// and Route requests over random names of the base, the same for every thread count. The output
+// of every thread count is checked against the one of a single thread.
+// Usage: requests_benchmark [max_threads] [requests] [make_base.json] [generated_requests.json]
+
+#include "benchmark_utils.h"
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using namespace std::literals;
+
+namespace {
+
+// share of every request type in the batch, in percent
+const int BUS_SHARE = 40;
+const int STOP_SHARE = 30;
+// the rest are Route requests, from a pool of pairs
+const size_t ROUTE_PAIRS = 2000;
+
+// true if the route and every edge of it can be answered
+bool CanBuildRoute(const CatalogueVersion& version, std::string_view from, std::string_view to) {
+    try {
+        if (const auto route = version.graph->BuildRoute(from, to)) {
+            for (const graph::EdgeId edge : route->edges) {
+                version.graph->GetLinkById(edge);
+            }
+        }
+        return true;
+    } catch (const std::exception&) {
+        return false;
+    }
+}
+
+// A document with "stat_requests" only, ids go from 0
+std::string MakeStatRequests(const CatalogueVersion& version, size_t count, uint32_t seed) {
+    std::mt19937 random(seed);
+
+    std::vector<std::string_view> buses;
+    for (const auto* bus : version.catalogue->GetAllRoutesIndex()) {
+        buses.push_back(bus->bus_name);
+    }
+    std::vector<std::string_view> stops;
+    for (const auto* stop : version.catalogue->GetAllStopsIndex()) {
+        stops.push_back(stop->stop_name);
+    }
+    if (buses.empty() || stops.empty()) {
+        throw std::runtime_error("The base has no buses or stops.");
+    }
+
+    std::uniform_int_distribution<size_t> bus_i(0, buses.size() - 1);
+    std::uniform_int_distribution<size_t> stop_i(0, stops.size() - 1);
+    std::uniform_int_distribution<int> percent(0, 99);
+
+    // pairs the graph cannot answer would stop the batch, they are left out
+    std::vector<std::pair<std::string_view, std::string_view>> route_pairs;
+    for (size_t attempt = 0; route_pairs.size() < ROUTE_PAIRS && attempt < ROUTE_PAIRS * 10; ++attempt) {
+        const std::string_view from = stops[stop_i(random)];
+        const std::string_view to = stops[stop_i(random)];
+        if (CanBuildRoute(version, from, to)) {
+            route_pairs.emplace_back(from, to);
+        }
+    }
+    std::uniform_int_distribution<size_t> route_i(0, route_pairs.empty() ? 0 : route_pairs.size() - 1);
+
+    std::ostringstream text;
+    json::Writer writer(text, 1 << 16, json::Writer::Layout::COMPACT);
+    writer.StartDict().Key("stat_requests"sv).StartArray();
+    for (size_t id = 0; id < count; ++id) {
+        writer.StartDict().Key("id"sv).Value(static_cast<int>(id));
+        const int type = percent(random);
+        if (type < BUS_SHARE) {
+            writer.Key("type"sv).Value("Bus"sv).Key("name"sv).Value(buses[bus_i(random)]);
+        } else if (type < BUS_SHARE + STOP_SHARE || route_pairs.empty()) {
+            writer.Key("type"sv).Value("Stop"sv).Key("name"sv).Value(stops[stop_i(random)]);
+        } else {
+            const auto& [from, to] = route_pairs[route_i(random)];
+            writer.Key("type"sv).Value("Route"sv).Key("from"sv).Value(from).Key("to"sv).Value(to);
+        }
+        writer.EndDict();
+    }
+    writer.EndArray().EndDict();
+    writer.Flush();
+
+    return text.str();
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    const size_t max_threads = std::stoul(benchmark::ArgOr(argc, argv, 1, "8"));
+    const size_t count = std::stoul(benchmark::ArgOr(argc, argv, 2, "60000"));
+    const std::string file = benchmark::ArgOr(argc, argv, 3, benchmark::DefaultMakeBase());
+    const std::string generated_file = benchmark::ArgOr(argc, argv, 4, "");
+
+    CatalogueSnapshots snapshots;
+    snapshots.Publish(benchmark::LoadMakeBase(file));
+    const std::string requests_text = MakeStatRequests(*snapshots.Acquire(), count, 1);
+    if (!generated_file.empty()) {
+        std::ofstream(generated_file) << requests_text;
+    }
+    const json::Document requests = json::Load(std::string_view(requests_text));
+
+    transport_catalogue::TransportCatalogue unused;
+    JsonReader reader(unused);
+    reader.UseSnapshots(snapshots);
+
+    std::cout << file << ": "sv << count << " requests, "sv << std::thread::hardware_concurrency()
+              << " hardware threads"sv << std::endl;
+
+    std::string single_thread_output;
+    bool same = true;
+    for (size_t threads = 1; threads <= max_threads; threads *= 2) {
+        std::ostringstream output;
+        const auto start = std::chrono::steady_clock::now();
+        reader.AnswerBatch(requests.GetRoot(), output, threads);
+        const double elapsed = benchmark::SecondsSince(start);
+
+        if (threads == 1) {
+            single_thread_output = output.str();
+        }
+        const bool thread_same = output.str() == single_thread_output;
+        same = same && thread_same;
+        std::cout << threads << " threads: "sv << static_cast<double>(count) / elapsed << " requests/s"sv
+                  << (thread_same ? ""sv : ", OUTPUT DIFFERS"sv) << std::endl;
+    }
+
+    return same ? EXIT_SUCCESS : EXIT_FAILURE;
+}
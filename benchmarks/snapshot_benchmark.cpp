@@ -0,0 +1,111 @@
+// Throughput of readers of CatalogueSnapshots with and without a writer publishing new versions.
+// Every read acquires the current version and asks it for the info of one bus.
+// Usage: snapshot_benchmark [readers] [seconds] [make_base.json]
+
+#include "benchmark_utils.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+using namespace std::literals;
+
+namespace {
+
+struct Phase {
+    double reads_per_second = 0.0;
+    size_t updates = 0;
+};
+
+Phase RunPhase(CatalogueSnapshots& snapshots, const std::vector<std::string>& bus_names, size_t readers,
+               double seconds, bool with_writer) {
+    std::atomic<bool> stop = false;
+    std::vector<size_t> reads(readers, 0);
+    size_t updates = 0;
+
+    std::vector<std::thread> threads;
+    for (size_t reader = 0; reader < readers; ++reader) {
+        threads.emplace_back([&, reader]() {
+            size_t count = 0;
+            for (size_t i = reader; !stop.load(std::memory_order_relaxed); i += readers) {
+                const auto version = snapshots.Acquire();
+                version->catalogue->GetBusInfo(bus_names[i % bus_names.size()]);
+                ++count;
+            }
+            reads[reader] = count;
+        });
+    }
+
+    // the writer moves the first bus back and forth, each time a new version with its own graph
+    std::thread writer;
+    if (with_writer) {
+        writer = std::thread([&]() {
+            while (!stop.load(std::memory_order_relaxed)) {
+                snapshots.Update([](transport_catalogue::TransportCatalogue& tc) {
+                    const auto* bus = *tc.GetAllRoutesIndex().begin();
+                    transport_catalogue::BusRoute changed = *bus;
+                    std::reverse(changed.route_stops.begin(), changed.route_stops.end());
+                    tc.ReplaceBus(changed);
+                });
+                ++updates;
+            }
+        });
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+    stop = true;
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    // the writer may be in the middle of an update, which does not count
+    const double elapsed = benchmark::SecondsSince(start);
+    if (writer.joinable()) {
+        writer.join();
+    }
+
+    size_t total = 0;
+    for (size_t count : reads) {
+        total += count;
+    }
+    return {static_cast<double>(total) / elapsed, updates};
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    const size_t readers = std::stoul(benchmark::ArgOr(argc, argv, 1, "4"));
+    const double seconds = std::stod(benchmark::ArgOr(argc, argv, 2, "3"));
+    const std::string file = benchmark::ArgOr(argc, argv, 3, benchmark::DefaultMakeBase());
+
+    CatalogueSnapshots snapshots;
+    snapshots.Publish(benchmark::LoadMakeBase(file));
+
+    std::vector<std::string> bus_names;
+    for (const auto* bus : snapshots.Acquire()->catalogue->GetAllRoutesIndex()) {
+        bus_names.emplace_back(bus->bus_name);
+    }
+    if (bus_names.empty()) {
+        std::cerr << "The base has no buses"sv << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::cout << file << ": "sv << bus_names.size() << " buses, "sv << readers << " readers, "sv
+              << std::thread::hardware_concurrency() << " hardware threads"sv << std::endl;
+
+    const Phase idle = RunPhase(snapshots, bus_names, readers, seconds, false);
+    std::cout << "without updates: "sv << idle.reads_per_second << " reads/s"sv << std::endl;
+
+    const Phase updating = RunPhase(snapshots, bus_names, readers, seconds, true);
+    std::cout << "during updates:  "sv << updating.reads_per_second << " reads/s, "sv
+              << updating.updates << " versions published ("sv
+              << static_cast<double>(updating.updates) / seconds << " per second)"sv << std::endl;
+    std::cout << "ratio: "sv << updating.reads_per_second / idle.reads_per_second << std::endl;
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,208 @@
+#pragma once
+
+#include "json.h"
+
+#include <cctype>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <utility>
+
+
+// The character-by-character istream parser that json::Load used before it parsed from a
+// buffer, kept only as the baseline of json_benchmark. It builds the same trees for valid
+// documents; unlike json::Load it accepts a missing ',' between items.
+namespace stream_json_parser {
+
+    using json::Array;
+    using json::Dict;
+    using json::Node;
+    using json::ParsingError;
+    using namespace std::literals;
+
+    inline Node LoadNode(std::istream& input);
+
+    inline bool IsSkipSymbol(char c) {
+        return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+    }
+
+    inline void FlushSkipSymbols(std::istream& input) {
+        char c;
+        while (input >> c) {
+            if (!IsSkipSymbol(c)) {
+                input.putback(c);
+                return;
+            }
+        }
+    }
+
+    inline Node LoadArray(std::istream& input) {
+        Array result;
+
+        char c = 0;
+        while (input >> c && c != ']') {
+            if (c != ',') {
+                input.putback(c);
+            }
+            result.push_back(LoadNode(input));
+            FlushSkipSymbols(input);
+        }
+        if (c != ']') {
+            throw ParsingError("Error loading array. Unexpected EOF.");
+        }
+
+        return Node(std::move(result));
+    }
+
+    inline Node LoadString(std::istream& input) {
+        auto it = std::istreambuf_iterator<char>(input);
+        const auto end = std::istreambuf_iterator<char>();
+        std::string s;
+        while (true) {
+            if (it == end) {
+                throw ParsingError("String parsing error");
+            }
+            const char ch = *it;
+            if (ch == '"') {
+                ++it;
+                break;
+            } else if (ch == '\\') {
+                ++it;
+                if (it == end) {
+                    throw ParsingError("String parsing error");
+                }
+                switch (const char escaped_char = *it) {
+                    case 'n': s.push_back('\n'); break;
+                    case 't': s.push_back('\t'); break;
+                    case 'r': s.push_back('\r'); break;
+                    case '"': s.push_back('"'); break;
+                    case '\\': s.push_back('\\'); break;
+                    default: throw ParsingError("Unrecognized escape sequence \\"s + escaped_char);
+                }
+            } else if (ch == '\n' || ch == '\r') {
+                throw ParsingError("Unexpected end of line"s);
+            } else {
+                s.push_back(ch);
+            }
+            ++it;
+        }
+
+        return Node(std::move(s));
+    }
+
+    inline Node LoadDict(std::istream& input) {
+        Dict result;
+
+        FlushSkipSymbols(input);
+        char c = 0;
+        while (input >> c && c != '}') {
+            if (c == ',') {
+                FlushSkipSymbols(input);
+                input >> c;
+            }
+
+            std::string key(LoadString(input).AsString());
+            FlushSkipSymbols(input);
+            input >> c; // the ':'
+            Node value = LoadNode(input);
+            result.emplace(std::move(key), std::move(value));
+            FlushSkipSymbols(input);
+        }
+        if (c != '}') {
+            throw ParsingError("Error wile loading dictionary. Unexpected EOF.");
+        }
+
+        return Node(std::move(result));
+    }
+
+    inline Node LoadNumber(std::istream& input) {
+        std::string parsed_num;
+
+        const auto read_char = [&parsed_num, &input] {
+            parsed_num += static_cast<char>(input.get());
+            if (!input) {
+                throw ParsingError("Failed to read number from stream"s);
+            }
+        };
+        const auto read_digits = [&input, read_char] {
+            if (!std::isdigit(input.peek())) {
+                throw ParsingError("A digit is expected"s);
+            }
+            while (std::isdigit(input.peek())) {
+                read_char();
+            }
+        };
+
+        if (input.peek() == '-') {
+            read_char();
+        }
+        if (input.peek() == '0') {
+            read_char();
+        } else {
+            read_digits();
+        }
+
+        bool is_int = true;
+        if (input.peek() == '.') {
+            read_char();
+            read_digits();
+            is_int = false;
+        }
+        if (int ch = input.peek(); ch == 'e' || ch == 'E') {
+            read_char();
+            if (ch = input.peek(); ch == '+' || ch == '-') {
+                read_char();
+            }
+            read_digits();
+            is_int = false;
+        }
+
+        try {
+            if (is_int) {
+                try {
+                    return Node(std::stoi(parsed_num));
+                } catch (...) {
+                    // out of int, read as double below
+                }
+            }
+            return Node(std::stod(parsed_num));
+        } catch (...) {
+            throw ParsingError("Failed to convert "s + parsed_num + " to number"s);
+        }
+    }
+
+    // true, false and null
+    inline Node LoadWord(std::istream& input) {
+        std::string word;
+        char c;
+        while (word.size() < 5 && std::isalpha(input.peek()) && input >> c) {
+            word += c;
+        }
+
+        if (word == "true"sv) return Node(true);
+        if (word == "false"sv) return Node(false);
+        if (word == "null"sv) return Node(nullptr);
+        throw ParsingError("Failed to read a literal, incorrect symbols presented."s);
+    }
+
+    inline Node LoadNode(std::istream& input) {
+        FlushSkipSymbols(input);
+
+        char c = 0;
+        input >> c;
+        if (c == '[') {
+            return LoadArray(input);
+        } else if (c == '{') {
+            return LoadDict(input);
+        } else if (c == '"') {
+            return LoadString(input);
+        }
+        input.putback(c);
+        if (c == 't' || c == 'f' || c == 'n') {
+            return LoadWord(input);
+        }
+        return LoadNumber(input);
+    }
+
+}  // namespace stream_json_parser
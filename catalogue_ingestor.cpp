@@ -0,0 +1,90 @@
+#include "catalogue_ingestor.h"
+
+#include <algorithm>
+#include <functional>
+#include <iterator>
+
+
+namespace transport_catalogue {
+
+CatalogueIngestor::CatalogueIngestor(size_t shard_count) {
+    shards_.reserve(std::max<size_t>(shard_count, 1));
+    for (size_t i = 0; i < std::max<size_t>(shard_count, 1); ++i) {
+        shards_.push_back(std::make_unique<Shard>());
+    }
+}
+
+CatalogueIngestor::Shard& CatalogueIngestor::ShardOf(std::string_view name) {
+    return *shards_[std::hash<std::string_view>{}(name) % shards_.size()];
+}
+
+bool CatalogueIngestor::AddStop(StopWithDistances&& stop) {
+    Shard& shard = ShardOf(stop.stop_name);
+    std::lock_guard<std::mutex> guard(shard.mutex);
+
+    if (!shard.stop_positions.emplace(stop.stop_name, shard.stops.size()).second) {
+        return false;
+    }
+    stop.id = 0; // ids are given by Freeze()
+    shard.stops.push_back(std::move(stop));
+
+    return true;
+}
+
+bool CatalogueIngestor::AddBus(BusWithStopNames&& bus) {
+    Shard& shard = ShardOf(bus.bus_name);
+    std::lock_guard<std::mutex> guard(shard.mutex);
+
+    if (!shard.bus_positions.emplace(bus.bus_name, shard.buses.size()).second) {
+        return false;
+    }
+    shard.buses.push_back(std::move(bus));
+
+    return true;
+}
+
+void CatalogueIngestor::AddDistance(std::string_view stop, std::string_view other_stop, size_t distance) {
+    Shard& shard = ShardOf(stop);
+    std::lock_guard<std::mutex> guard(shard.mutex);
+
+    shard.distances.emplace_back(std::string(stop), StopDistanceData{std::string(other_stop), distance});
+}
+
+size_t CatalogueIngestor::Freeze(TransportCatalogue& tc) {
+    size_t rejected = 0;
+    std::vector<StopWithDistances> stops;
+    std::vector<BusWithStopNames> buses;
+
+    for (const auto& shard_ptr : shards_) {
+        Shard& shard = *shard_ptr;
+        // separate distances join their stops, which live in the same shard
+        for (auto& [stop_name, distance] : shard.distances) {
+            const auto position = shard.stop_positions.find(stop_name);
+            if (position == shard.stop_positions.end()) {
+                ++rejected;
+                continue;
+            }
+            shard.stops[position->second].distances.push_back(std::move(distance));
+        }
+        std::move(shard.stops.begin(), shard.stops.end(), std::back_inserter(stops));
+        std::move(shard.buses.begin(), shard.buses.end(), std::back_inserter(buses));
+
+        shard.stops.clear();
+        shard.stop_positions.clear();
+        shard.buses.clear();
+        shard.bus_positions.clear();
+        shard.distances.clear();
+    }
+
+    // ids follow the names, so the result is the same whatever the order of producers was
+    std::sort(stops.begin(), stops.end(), [](const StopWithDistances& lhs, const StopWithDistances& rhs) {
+        return lhs.stop_name < rhs.stop_name;
+    });
+    std::sort(buses.begin(), buses.end(), [](const BusWithStopNames& lhs, const BusWithStopNames& rhs) {
+        return lhs.bus_name < rhs.bus_name;
+    });
+
+    return rejected + tc.BulkLoad(std::move(stops), std::move(buses));
+}
+
+} // namespace transport_catalogue
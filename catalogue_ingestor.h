@@ -0,0 +1,52 @@
+#pragma once
+
+#include "domain.h"
+#include "transport_catalogue.h"
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+
+namespace transport_catalogue {
+
+// Collects stops, distances and buses from several producer threads at once. Names are spread
+// over shards by hash, and every shard has its own lock, so producers rarely wait for each other.
+// Nothing is resolved while producing: Freeze() orders everything by name, so ids do not depend on
+// thread timing, and loads the result into a catalogue in one BulkLoad.
+class CatalogueIngestor {
+public:
+    explicit CatalogueIngestor(size_t shard_count = 64);
+    CatalogueIngestor(const CatalogueIngestor&) = delete;
+    CatalogueIngestor& operator=(const CatalogueIngestor&) = delete;
+
+    // All of these may be called from any number of threads. A repeated stop or bus name is refused.
+    bool AddStop(StopWithDistances&& stop);
+    bool AddBus(BusWithStopNames&& bus);
+    // The stop may be added later, it has to be there by Freeze(). The last distance given for a pair wins.
+    void AddDistance(std::string_view stop, std::string_view other_stop, size_t distance);
+
+    // Loads everything into the catalogue and empties the ingestor; returns the number of rejected
+    // entries, the same way as BulkLoad does. Must not run concurrently with producers.
+    size_t Freeze(TransportCatalogue& tc);
+
+private:
+    struct Shard {
+        std::mutex mutex;
+        std::vector<StopWithDistances> stops;
+        std::unordered_map<std::string, size_t> stop_positions;
+        std::vector<BusWithStopNames> buses;
+        std::unordered_map<std::string, size_t> bus_positions;
+        // distances given apart from their stop, this shard holds the stops they start from
+        std::vector<std::pair<std::string, StopDistanceData>> distances;
+    };
+
+    std::vector<std::unique_ptr<Shard>> shards_;
+
+    Shard& ShardOf(std::string_view name);
+};
+
+} // namespace transport_catalogue
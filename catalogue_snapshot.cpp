@@ -0,0 +1,81 @@
+#include "catalogue_snapshot.h"
+#include "serialization.h"
+
+#include <atomic>
+#include <stdexcept>
+
+
+std::shared_ptr<transport_catalogue::StopsSpatialIndex> RestoreSpatialIndex(const transport_catalogue::TransportCatalogue& tc,
+                                                                          const tc_serialize::TransportCatalogue& t_cat) {
+    if (t_cat.base_settings().has_spatial_index()) {
+        return std::make_shared<transport_catalogue::StopsSpatialIndex>(tc, t_cat.base_settings().spatial_index());
+    }
+    // bases made before the index was introduced
+    return std::make_shared<transport_catalogue::StopsSpatialIndex>(tc);
+}
+
+std::shared_ptr<CatalogueVersion> LoadCatalogueVersion(tc_serialize::TransportCatalogue& t_cat) {
+    auto catalogue = std::make_shared<transport_catalogue::TransportCatalogue>();
+    if (!catalogue->RestoreFrom(t_cat)) {
+        throw std::runtime_error("Error restoring the transport catalogue from the base.");
+    }
+
+    auto version = std::make_shared<CatalogueVersion>();
+    version->renderer_settings.emplace(DeserializeRenderSetting(t_cat.render_settings()));
+    version->routing_settings = DeserializeRouting(t_cat.router_settings().routing_settings());
+    version->graph = std::make_shared<TransportCatalogueRouterGraph>(*catalogue, version->routing_settings, t_cat);
+    version->spatial_index = RestoreSpatialIndex(*catalogue, t_cat);
+    version->catalogue = std::move(catalogue);
+
+    return version;
+}
+
+
+std::shared_ptr<const CatalogueVersion> CatalogueSnapshots::Acquire() const {
+    return std::atomic_load(&current_);
+}
+
+uint64_t CatalogueSnapshots::Publish(std::shared_ptr<CatalogueVersion> version) {
+    std::lock_guard<std::mutex> guard(writers_mutex_);
+
+    const auto current = std::atomic_load(&current_);
+    version->number = current ? current->number + 1 : 1;
+    const uint64_t number = version->number;
+    std::atomic_store(&current_, std::shared_ptr<const CatalogueVersion>(std::move(version)));
+
+    return number;
+}
+
+uint64_t CatalogueSnapshots::Update(const CatalogueChange& change) {
+    std::lock_guard<std::mutex> guard(writers_mutex_);
+
+    const auto current = std::atomic_load(&current_);
+    if (!current) {
+        throw std::logic_error("Error updating the catalogue, no version is published yet.");
+    }
+
+    auto catalogue = std::make_shared<transport_catalogue::TransportCatalogue>(*current->catalogue);
+    change(*catalogue);
+
+    auto version = std::make_shared<CatalogueVersion>();
+    version->number = current->number + 1;
+    version->routing_settings = current->routing_settings;
+    version->renderer_settings = current->renderer_settings;
+    if (catalogue->GetRoutingRevision() == current->catalogue->GetRoutingRevision()) {
+        version->graph = current->graph;
+        version->graph_catalogue = current->graph_catalogue ? current->graph_catalogue : current->catalogue;
+    } else {
+        version->graph = std::make_shared<TransportCatalogueRouterGraph>(*catalogue, version->routing_settings);
+    }
+    if (catalogue->SharesStopsWith(*current->catalogue)) {
+        version->spatial_index = current->spatial_index;
+    } else {
+        version->spatial_index = std::make_shared<transport_catalogue::StopsSpatialIndex>(*catalogue);
+    }
+    version->catalogue = std::move(catalogue);
+
+    const uint64_t number = version->number;
+    std::atomic_store(&current_, std::shared_ptr<const CatalogueVersion>(std::move(version)));
+
+    return number;
+}
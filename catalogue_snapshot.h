@@ -0,0 +1,69 @@
+#pragma once
+
+#include "transport_catalogue.h"
+#include "transport_catalogue.pb.h"
+#include "transport_router.h"
+#include "map_renderer.h"
+#include "spatial_index.h"
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+
+
+// One frozen, immutable version of the data that queries are answered from.
+// The graph and the spatial index are shared with the previous version when the change did not touch
+// what they are built of. The graph then refers to the catalogue of an older version, which it keeps alive.
+struct CatalogueVersion {
+    uint64_t number = 0;
+    std::shared_ptr<const transport_catalogue::TransportCatalogue> catalogue;
+    std::shared_ptr<const TransportCatalogueRouterGraph> graph;
+    // the catalogue the graph was built for, if it is not the one above
+    std::shared_ptr<const transport_catalogue::TransportCatalogue> graph_catalogue;
+    std::shared_ptr<const transport_catalogue::StopsSpatialIndex> spatial_index;
+    RoutingSettings routing_settings {};
+    std::optional<RendererSettings> renderer_settings;
+
+    // The map of a version never changes, so it is rendered by the first Map request only,
+    // right into a JSON string: quotes and escapes included
+    mutable std::once_flag map_rendered;
+    mutable std::string map_json;
+};
+
+// Takes the spatial index saved in the base, or builds it if the base has none
+std::shared_ptr<transport_catalogue::StopsSpatialIndex> RestoreSpatialIndex(const transport_catalogue::TransportCatalogue& tc,
+                                                                          const tc_serialize::TransportCatalogue& t_cat);
+
+// Builds a complete version from a serialized base
+std::shared_ptr<CatalogueVersion> LoadCatalogueVersion(tc_serialize::TransportCatalogue& t_cat);
+
+
+// Holder of the current version. Readers take a shared_ptr to the published version and keep
+// using it as long as they need, they never wait for writers. Writers are serialized among
+// themselves, build the next version aside and publish it with one atomic pointer swap.
+// An old version is freed when its last reader releases it.
+class CatalogueSnapshots {
+public:
+    using CatalogueChange = std::function<void(transport_catalogue::TransportCatalogue&)>;
+
+    CatalogueSnapshots() = default;
+    CatalogueSnapshots(const CatalogueSnapshots&) = delete;
+    CatalogueSnapshots& operator=(const CatalogueSnapshots&) = delete;
+
+    std::shared_ptr<const CatalogueVersion> Acquire() const;
+
+    // Publishes a prepared version, returns its number
+    uint64_t Publish(std::shared_ptr<CatalogueVersion> version);
+
+    // Copies the current catalogue, applies the change to the copy and publishes the result.
+    // The copy shares the stops, distances and buses with the current one until the change touches them.
+    // The routing graph is built anew only if stops, distances or buses changed, the spatial index
+    // only if stops were added or moved. Readers keep working on the previous version meanwhile.
+    uint64_t Update(const CatalogueChange& change);
+
+private:
+    std::shared_ptr<const CatalogueVersion> current_;
+    std::mutex writers_mutex_;
+};
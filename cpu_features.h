@@ -0,0 +1,21 @@
+#pragma once
+
+// SIMD code paths are compiled with GCC/Clang target attributes on x86 only,
+// everywhere else the scalar versions are used.
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define TC_X86_SIMD 1
+#endif
+
+namespace cpu {
+
+    // checked once with CPUID, true if AVX2 code paths may run on this processor
+    inline bool HasAvx2() {
+#ifdef TC_X86_SIMD
+        static const bool result = __builtin_cpu_supports("avx2");
+        return result;
+#else
+        return false;
+#endif
+    }
+
+}  // namespace cpu
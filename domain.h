@@ -37,8 +37,13 @@ namespace transport_catalogue {
         std::vector<const Stop *> route_stops;
     };
 
+    struct BusWithStopNames {
+        std::string bus_name;
+        RouteType type;
+        std::vector<std::string> route_stops;
+    };
+
     const BusRoute EMPTY_BUS_ROUTE{};
-    const std::set<std::string_view> EMPTY_BUS_ROUTE_SET{};
 
     struct BusInfo {
         std::string_view bus_name;
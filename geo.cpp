@@ -1,10 +1,121 @@
 #define _USE_MATH_DEFINES
 #include "geo.h"
+#include "cpu_features.h"
 
+#include <algorithm>
 #include <cmath>
 
+#ifdef TC_X86_SIMD
+#include <immintrin.h>
+#endif
+
 namespace geo {
 
+    namespace {
+
+        // Haversine term of a pair: sin^2(dlat/2) + cos(lat1) * cos(lat2) * sin^2(dlng/2).
+        // Differences of half angles come from the angle subtraction formula, so there is no
+        // cancellation for close points, unlike with acos of the spherical law of cosines.
+        inline double HaversineTerm(const CoordinatesTrig& from, const CoordinatesTrig& to) {
+            const double sin_dlat = to.sin_half_lat * from.cos_half_lat - to.cos_half_lat * from.sin_half_lat;
+            const double sin_dlng = to.sin_half_lng * from.cos_half_lng - to.cos_half_lng * from.sin_half_lng;
+            const double cos_lat_from = 1.0 - 2.0 * from.sin_half_lat * from.sin_half_lat;
+            const double cos_lat_to = 1.0 - 2.0 * to.sin_half_lat * to.sin_half_lat;
+            return sin_dlat * sin_dlat + cos_lat_from * cos_lat_to * sin_dlng * sin_dlng;
+        }
+
+        inline double HaversineToMeters(double term) {
+            return 2.0 * EARTH_RADIUS * std::asin(std::sqrt(std::clamp(term, 0.0, 1.0)));
+        }
+
+#ifdef TC_X86_SIMD
+        // four points, one per register, into four registers with one field of all points each
+        __attribute__((target("avx2")))
+        inline void Transpose(const CoordinatesTrig* points, __m256d& sin_lat, __m256d& cos_lat, __m256d& sin_lng, __m256d& cos_lng) {
+            const __m256d r0 = _mm256_loadu_pd(&points[0].sin_half_lat);
+            const __m256d r1 = _mm256_loadu_pd(&points[1].sin_half_lat);
+            const __m256d r2 = _mm256_loadu_pd(&points[2].sin_half_lat);
+            const __m256d r3 = _mm256_loadu_pd(&points[3].sin_half_lat);
+            const __m256d t0 = _mm256_unpacklo_pd(r0, r1);
+            const __m256d t1 = _mm256_unpackhi_pd(r0, r1);
+            const __m256d t2 = _mm256_unpacklo_pd(r2, r3);
+            const __m256d t3 = _mm256_unpackhi_pd(r2, r3);
+            sin_lat = _mm256_permute2f128_pd(t0, t2, 0x20);
+            cos_lat = _mm256_permute2f128_pd(t1, t3, 0x20);
+            sin_lng = _mm256_permute2f128_pd(t0, t2, 0x31);
+            cos_lng = _mm256_permute2f128_pd(t1, t3, 0x31);
+        }
+
+        __attribute__((target("avx2")))
+        inline __m256d HaversineTerm4(__m256d f_sin_lat, __m256d f_cos_lat, __m256d f_sin_lng, __m256d f_cos_lng,
+                                      __m256d t_sin_lat, __m256d t_cos_lat, __m256d t_sin_lng, __m256d t_cos_lng) {
+            const __m256d one = _mm256_set1_pd(1.0);
+            const __m256d two = _mm256_set1_pd(2.0);
+            const __m256d sin_dlat = _mm256_sub_pd(_mm256_mul_pd(t_sin_lat, f_cos_lat), _mm256_mul_pd(t_cos_lat, f_sin_lat));
+            const __m256d sin_dlng = _mm256_sub_pd(_mm256_mul_pd(t_sin_lng, f_cos_lng), _mm256_mul_pd(t_cos_lng, f_sin_lng));
+            const __m256d cos_lat_from = _mm256_sub_pd(one, _mm256_mul_pd(two, _mm256_mul_pd(f_sin_lat, f_sin_lat)));
+            const __m256d cos_lat_to = _mm256_sub_pd(one, _mm256_mul_pd(two, _mm256_mul_pd(t_sin_lat, t_sin_lat)));
+            return _mm256_add_pd(_mm256_mul_pd(sin_dlat, sin_dlat),
+                                 _mm256_mul_pd(_mm256_mul_pd(cos_lat_from, cos_lat_to), _mm256_mul_pd(sin_dlng, sin_dlng)));
+        }
+
+        __attribute__((target("avx2")))
+        inline __m256d HaversineTerm4(__m256d f_sin_lat, __m256d f_cos_lat, __m256d f_sin_lng, __m256d f_cos_lng,
+                                      const CoordinatesTrig* to) {
+            __m256d t_sin_lat, t_cos_lat, t_sin_lng, t_cos_lng;
+            Transpose(to, t_sin_lat, t_cos_lat, t_sin_lng, t_cos_lng);
+            return HaversineTerm4(f_sin_lat, f_cos_lat, f_sin_lng, f_cos_lng, t_sin_lat, t_cos_lat, t_sin_lng, t_cos_lng);
+        }
+
+        // haversine terms from one point, four at a time; the tail and asin are done by the caller
+        __attribute__((target("avx2")))
+        size_t HaversineTermsFromAvx2(const CoordinatesTrig& from, const CoordinatesTrig* to, size_t count, double* result) {
+            const __m256d f_sin_lat = _mm256_set1_pd(from.sin_half_lat);
+            const __m256d f_cos_lat = _mm256_set1_pd(from.cos_half_lat);
+            const __m256d f_sin_lng = _mm256_set1_pd(from.sin_half_lng);
+            const __m256d f_cos_lng = _mm256_set1_pd(from.cos_half_lng);
+
+            size_t i = 0;
+            for (; i + 4 <= count; i += 4) {
+                _mm256_storeu_pd(result + i, HaversineTerm4(f_sin_lat, f_cos_lat, f_sin_lng, f_cos_lng, to + i));
+            }
+            return i;
+        }
+
+        // haversine terms of from[i] and to[i], four pairs at a time
+        __attribute__((target("avx2")))
+        size_t HaversineTermsPairsAvx2(const CoordinatesTrig* from, const CoordinatesTrig* to, size_t count, double* result) {
+            size_t i = 0;
+            for (; i + 4 <= count; i += 4) {
+                __m256d f_sin_lat, f_cos_lat, f_sin_lng, f_cos_lng;
+                Transpose(from + i, f_sin_lat, f_cos_lat, f_sin_lng, f_cos_lng);
+                _mm256_storeu_pd(result + i, HaversineTerm4(f_sin_lat, f_cos_lat, f_sin_lng, f_cos_lng, to + i));
+            }
+            return i;
+        }
+#endif
+
+        void ComputeDistancesImpl(const CoordinatesTrig* from, size_t from_step, const CoordinatesTrig* to, size_t count,
+                                  double* result, bool use_simd) {
+            size_t done = 0;
+#ifdef TC_X86_SIMD
+            if (use_simd && cpu::HasAvx2()) {
+                done = from_step == 0 ? HaversineTermsFromAvx2(*from, to, count, result)
+                                      : HaversineTermsPairsAvx2(from, to, count, result);
+            }
+#else
+            (void)use_simd;
+#endif
+            for (size_t i = done; i < count; ++i) {
+                result[i] = HaversineTerm(from[i * from_step], to[i]);
+            }
+            for (size_t i = 0; i < count; ++i) {
+                result[i] = HaversineToMeters(result[i]);
+            }
+        }
+
+    }  // namespace
+
     double ComputeDistance(Coordinates from, Coordinates to) {
         using namespace std;
         if (from == to) {
@@ -13,7 +124,25 @@ namespace geo {
         static const double dr = M_PI / 180.;
         return acos(sin(from.lat * dr) * sin(to.lat * dr)
                     + cos(from.lat * dr) * cos(to.lat * dr) * cos(abs(from.lng - to.lng) * dr))
-               * 6371000;
+               * EARTH_RADIUS;
+    }
+
+    CoordinatesTrig ComputeTrig(Coordinates coords) {
+        const double half_lat = coords.lat * DEGREE_TO_RAD / 2.0;
+        const double half_lng = coords.lng * DEGREE_TO_RAD / 2.0;
+        return {std::sin(half_lat), std::cos(half_lat), std::sin(half_lng), std::cos(half_lng)};
+    }
+
+    void ComputeDistances(const CoordinatesTrig* from, const CoordinatesTrig* to, size_t count, double* result) {
+        ComputeDistancesImpl(from, 1, to, count, result, true);
+    }
+
+    void ComputeDistancesScalar(const CoordinatesTrig* from, const CoordinatesTrig* to, size_t count, double* result) {
+        ComputeDistancesImpl(from, 1, to, count, result, false);
+    }
+
+    void ComputeDistancesFrom(const CoordinatesTrig& from, const CoordinatesTrig* to, size_t count, double* result) {
+        ComputeDistancesImpl(&from, 0, to, count, result, true);
     }
 
-}  // namespace geo
\ No newline at end of file
+}  // namespace geo
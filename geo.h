@@ -1,7 +1,13 @@
 #pragma once
 
+#include <cstddef>
+
 namespace geo {
 
+    const double EARTH_RADIUS = 6371000.0; // meters
+    const double DEGREE_TO_RAD = 3.14159265358979323846 / 180.0;
+    const double METERS_IN_DEGREE = EARTH_RADIUS * DEGREE_TO_RAD; // along a meridian
+
     struct Coordinates {
         double lat; // Широта
         double lng; // Долгота
@@ -13,6 +19,24 @@ namespace geo {
         }
     };
 
+    // Sines and cosines of the half angles of a point, computed once per stop.
+    // Four doubles, so one point fills exactly one AVX register.
+    struct CoordinatesTrig {
+        double sin_half_lat;
+        double cos_half_lat;
+        double sin_half_lng;
+        double cos_half_lng;
+    };
+
     double ComputeDistance(Coordinates from, Coordinates to);
 
-}  // namespace geo
\ No newline at end of file
+    CoordinatesTrig ComputeTrig(Coordinates coords);
+
+    // Haversine distances between from[i] and to[i], no trigonometry except one asin per pair
+    void ComputeDistances(const CoordinatesTrig* from, const CoordinatesTrig* to, size_t count, double* result);
+    // Haversine distances from one point to every point of to
+    void ComputeDistancesFrom(const CoordinatesTrig& from, const CoordinatesTrig* to, size_t count, double* result);
+    // ComputeDistances without the SIMD kernels, the reference they are checked against
+    void ComputeDistancesScalar(const CoordinatesTrig* from, const CoordinatesTrig* to, size_t count, double* result);
+
+}  // namespace geo
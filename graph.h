@@ -1,5 +1,6 @@
 #pragma once
 
+#include "memory_usage.h"
 #include "ranges.h"
 
 #include <cstdlib>
@@ -34,6 +35,8 @@ namespace graph {
         const Edge<Weight>& GetEdge(EdgeId edge_id) const;
         IncidentEdgesRange GetIncidentEdges(VertexId vertex) const;
 
+        memory::MemoryUsage MemoryUsage() const;
+
     protected:
         std::vector<Edge<Weight>> edges_;
         std::vector<IncidenceList> incidence_lists_;
@@ -72,4 +75,16 @@ namespace graph {
     DirectedWeightedGraph<Weight>::GetIncidentEdges(VertexId vertex) const {
         return ranges::AsRange(incidence_lists_.at(vertex));
     }
+
+    template <typename Weight>
+    memory::MemoryUsage DirectedWeightedGraph<Weight>::MemoryUsage() const {
+        memory::MemoryUsage usage;
+        usage.Add("edges", memory::BytesOf(edges_));
+        size_t incidence_bytes = memory::BytesOf(incidence_lists_);
+        for (const IncidenceList& list : incidence_lists_) {
+            incidence_bytes += memory::BytesOf(list);
+        }
+        usage.Add("incidence_lists", incidence_bytes);
+        return usage;
+    }
 }  // namespace graph
\ No newline at end of file
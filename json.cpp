@@ -1,5 +1,17 @@
 #include "json.h"
+#include "cpu_features.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
 #include <exception>
+#include <iterator>
+#include <limits>
+
+#ifdef TC_X86_SIMD
+#include <immintrin.h>
+#endif
 
 using namespace std;
 
@@ -7,277 +19,484 @@ namespace json {
 
     namespace {
 
-        inline const size_t SKIP_NUM = 4;
-        inline const char SKIP_SYMBOLS[SKIP_NUM] = {' ', '\t', '\r' ,'\n'};
-
-        Node LoadNode(istream& input);
-
         bool IsSkipSymbol(char c) {
-            for (size_t i = 0; i < SKIP_NUM; ++i) {
-                if (c == SKIP_SYMBOLS[i]) {
-                    return true;
-                }
-            }
-            return false;
+            return c == ' ' || c == '\t' || c == '\r' || c == '\n';
         }
 
-        void FlushSkipSymbols(std::istream& strm) {
-            char c;
+        bool IsDigit(char c) {
+            return c >= '0' && c <= '9';
+        }
 
-            while ( strm >> c ) {
-                if ( !IsSkipSymbol(c) ){
-                    strm.putback(c);
-                    return;
+        // Parsing goes in two stages. The first one classifies the input 64 bytes at a time and
+        // builds the structural index: positions of {}[],: outside of strings, of every unescaped
+        // quote and of the first symbol of every number or literal. The second one builds the tree
+        // going from one indexed position to the next, it never looks at spaces or string bodies.
+
+        const size_t BLOCK_SIZE = 64;
+
+        // bit i is set if symbol i of the block is of the kind
+        struct BlockMasks {
+            uint64_t quote = 0;
+            uint64_t backslash = 0;
+            uint64_t op = 0; // {}[],:
+            uint64_t space = 0;
+            uint64_t line = 0; // \r\n
+        };
+
+        void ClassifyBlock(const char* block, BlockMasks& masks) {
+            for (size_t i = 0; i < BLOCK_SIZE; ++i) {
+                const uint64_t bit = uint64_t{1} << i;
+                switch (block[i]) {
+                    case '"': masks.quote |= bit; break;
+                    case '\\': masks.backslash |= bit; break;
+                    case '{': case '}': case '[': case ']': case ',': case ':': masks.op |= bit; break;
+                    case ' ': case '\t': masks.space |= bit; break;
+                    case '\r': case '\n': masks.space |= bit; masks.line |= bit; break;
+                    default: break;
                 }
             }
         }
 
+#ifdef TC_X86_SIMD
+        __attribute__((target("avx2")))
+        inline uint64_t EqualMask(__m256i lo, __m256i hi, char c) {
+            const __m256i pattern = _mm256_set1_epi8(c);
+            const uint32_t lo_bits = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(lo, pattern)));
+            const uint32_t hi_bits = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(hi, pattern)));
+            return uint64_t{lo_bits} | (uint64_t{hi_bits} << 32);
+        }
 
-        Node LoadArray(istream& input) {
-            Array result;
-
-            char c;
-            while (input >> c && c != ']') {
-                if (c != ',') {
-                    input.putback(c);
+        __attribute__((target("avx2")))
+        void ClassifyBlockAvx2(const char* block, BlockMasks& masks) {
+            const __m256i lo = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block));
+            const __m256i hi = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + 32));
+            masks.quote = EqualMask(lo, hi, '"');
+            masks.backslash = EqualMask(lo, hi, '\\');
+            masks.op = EqualMask(lo, hi, '{') | EqualMask(lo, hi, '}') | EqualMask(lo, hi, '[')
+                     | EqualMask(lo, hi, ']') | EqualMask(lo, hi, ',') | EqualMask(lo, hi, ':');
+            masks.line = EqualMask(lo, hi, '\r') | EqualMask(lo, hi, '\n');
+            masks.space = masks.line | EqualMask(lo, hi, ' ') | EqualMask(lo, hi, '\t');
+        }
+#endif
+
+        // Symbols escaped by a backslash. A backslash escapes the next symbol unless it is escaped itself,
+        // escaped_carry tells if the first symbol of the next block is escaped.
+        uint64_t EscapedMask(uint64_t backslash, uint64_t& escaped_carry) {
+            uint64_t escaped = escaped_carry;
+            escaped_carry = 0;
+            backslash &= ~escaped;
+            while (backslash != 0) {
+                const uint64_t bit = backslash & (~backslash + 1);
+                const uint64_t next = bit << 1;
+                if (next == 0) {
+                    escaped_carry = 1;
                 }
-                result.push_back(LoadNode(input)); // LoadNode will take care of its skips
-                FlushSkipSymbols(input); // Flush after the node, till the ',' most likely
-            }
-            if (c != ']') {
-                throw ParsingError("Error loading array. Unexpected EOF.");
+                escaped |= next;
+                backslash &= ~(bit | next);
             }
+            return escaped;
+        }
 
-            return Node(move(result));
+        // bit i is the xor of bits 0..i: with quotes as input, the symbols inside strings, opening quote included
+        uint64_t PrefixXor(uint64_t bits) {
+            bits ^= bits << 1;
+            bits ^= bits << 2;
+            bits ^= bits << 4;
+            bits ^= bits << 8;
+            bits ^= bits << 16;
+            bits ^= bits << 32;
+            return bits;
         }
 
+        std::vector<uint32_t> BuildStructuralIndex(std::string_view input) {
+            if (input.size() >= std::numeric_limits<uint32_t>::max()) {
+                throw ParsingError("Document is too large"s);
+            }
 
-        Node LoadString(std::istream& input) {
-            using namespace std::literals;
+            std::vector<uint32_t> positions;
+            positions.reserve(input.size() / 8);
+
+#ifdef TC_X86_SIMD
+            const bool use_avx2 = cpu::HasAvx2();
+#endif
+            uint64_t escaped_carry = 0;
+            uint64_t in_string_carry = 0; // all ones while a string goes on into the next block
+            uint64_t separator_carry = 1; // the document starts as if after a separator
+
+            for (size_t offset = 0; offset < input.size(); offset += BLOCK_SIZE) {
+                const char* block = input.data() + offset;
+                char tail[BLOCK_SIZE];
+                if (input.size() - offset < BLOCK_SIZE) {
+                    std::memset(tail, ' ', BLOCK_SIZE);
+                    std::memcpy(tail, block, input.size() - offset);
+                    block = tail;
+                }
 
-            auto it = std::istreambuf_iterator<char>(input);
-            auto end = std::istreambuf_iterator<char>();
-            std::string s;
-            while (true) {
-                if (it == end) {
-                    // Поток закончился до того, как встретили закрывающую кавычку?
-                    throw ParsingError("String parsing error");
+                BlockMasks masks;
+#ifdef TC_X86_SIMD
+                if (use_avx2) {
+                    ClassifyBlockAvx2(block, masks);
+                } else {
+                    ClassifyBlock(block, masks);
                 }
-                const char ch = *it;
-                if (ch == '"') {
-                    // Встретили закрывающую кавычку
-                    ++it;
-                    break;
-                } else if (ch == '\\') {
-                    // Встретили начало escape-последовательности
-                    ++it;
-                    if (it == end) {
-                        // Поток завершился сразу после символа обратной косой черты
-                        throw ParsingError("String parsing error");
-                    }
-                    const char escaped_char = *(it);
-                    // Обрабатываем одну из последовательностей: \\, \n, \t, \r, \"
-                    switch (escaped_char) {
-                        case 'n':
-                            s.push_back('\n');
-                            break;
-                        case 't':
-                            s.push_back('\t');
-                            break;
-                        case 'r':
-                            s.push_back('\r');
-                            break;
-                        case '"':
-                            s.push_back('"');
-                            break;
-                        case '\\':
-                            s.push_back('\\');
-                            break;
-                        default:
-                            // Встретили неизвестную escape-последовательность
-                            throw ParsingError("Unrecognized escape sequence \\"s + escaped_char);
-                    }
-                } else if (ch == '\n' || ch == '\r') {
-                    // Строковый литерал внутри- JSON не может прерываться символами \r или \n
+#else
+                ClassifyBlock(block, masks);
+#endif
+
+                const uint64_t quotes = masks.quote & ~EscapedMask(masks.backslash, escaped_carry);
+                const uint64_t in_string = PrefixXor(quotes) ^ in_string_carry;
+                in_string_carry = (in_string >> 63) != 0 ? ~uint64_t{0} : 0;
+                if ((masks.line & in_string) != 0) {
+                    // Строковый литерал внутри JSON не может прерываться символами \r или \n
                     throw ParsingError("Unexpected end of line"s);
-                } else {
-                    // Просто считываем очередной символ и помещаем его в результирующую строку
-                    s.push_back(ch);
                 }
-                ++it;
-            }
 
-            return Node(std::move(s));
-        }
+                // a number or a literal starts after a separator
+                const uint64_t separators = masks.space | masks.op | quotes;
+                const uint64_t scalar_starts = ~separators & ~in_string & ((separators << 1) | separator_carry);
+                separator_carry = separators >> 63;
 
-        Node LoadDict(istream& input) {
-            Dict result;
-
-            FlushSkipSymbols(input);
-            char c;
-            while (input >> c && c != '}') {
-                if (c == ',') {
-                    FlushSkipSymbols(input); // flush skips after ','
-                    input >> c;
+                uint64_t structurals = (masks.op & ~in_string) | quotes | scalar_starts;
+                while (structurals != 0) {
+                    positions.push_back(static_cast<uint32_t>(offset + __builtin_ctzll(structurals)));
+                    structurals &= structurals - 1;
                 }
-
-                string key = LoadString(input).AsString();
-                FlushSkipSymbols(input); // flush skips, then the next symbol must be ':'
-                input >> c; // eat it up
-                result.insert({move(key), LoadNode(input)}); // LoadNode will take care of its own skips
-                FlushSkipSymbols(input); // flush skips after the value
             }
-            if (c != '}') {
-                throw ParsingError("Error wile loading dictionary. Unexpected EOF.");
+            if (in_string_carry != 0) {
+                throw ParsingError("String parsing error"s);
             }
 
-            return Node(move(result));
+            return positions;
         }
 
-
-        Node LoadNumber(std::istream& input) {
-            using namespace std::literals;
-
-            std::string parsed_num;
-
-            // Считывает в parsed_num очередной символ из input
-            auto read_char = [&parsed_num, &input] {
-                parsed_num += static_cast<char>(input.get());
-                if (!input) {
-                    throw ParsingError("Failed to read number from stream"s);
+        // the text goes to s, which may come with an allocator of its own
+        template <typename Str>
+        void Unescape(std::string_view body, Str& s) {
+            s.reserve(body.size());
+            for (size_t i = 0; i < body.size(); ++i) {
+                if (body[i] != '\\') {
+                    s.push_back(body[i]);
+                    continue;
                 }
-            };
+                if (++i == body.size()) {
+                    throw ParsingError("String parsing error"s);
+                }
+                // Обрабатываем одну из последовательностей: \\, \n, \t, \r, \"
+                switch (body[i]) {
+                    case 'n':
+                        s.push_back('\n');
+                        break;
+                    case 't':
+                        s.push_back('\t');
+                        break;
+                    case 'r':
+                        s.push_back('\r');
+                        break;
+                    case '"':
+                        s.push_back('"');
+                        break;
+                    case '\\':
+                        s.push_back('\\');
+                        break;
+                    default:
+                        throw ParsingError("Unrecognized escape sequence \\"s + body[i]);
+                }
+            }
+        }
+
+        Node ParseNumber(std::string_view token) {
+            const char* pos = token.data();
+            const char* end = token.data() + token.size();
 
-            // Считывает одну или более цифр в parsed_num из input
-            auto read_digits = [&input, read_char] {
-                if (!std::isdigit(input.peek())) {
+            auto read_digits = [&pos, end] {
+                if (pos == end || !IsDigit(*pos)) {
                     throw ParsingError("A digit is expected"s);
                 }
-                while (std::isdigit(input.peek())) {
-                    read_char();
+                while (pos != end && IsDigit(*pos)) {
+                    ++pos;
                 }
             };
 
-            if (input.peek() == '-') {
-                read_char();
+            if (pos != end && *pos == '-') {
+                ++pos;
             }
-            // Парсим целую часть числа
-            if (input.peek() == '0') {
-                read_char();
-                // После 0 в JSON не могут идти другие цифры
+            // После 0 в JSON не могут идти другие цифры
+            if (pos != end && *pos == '0') {
+                ++pos;
             } else {
                 read_digits();
             }
 
             bool is_int = true;
-            // Парсим дробную часть числа
-            if (input.peek() == '.') {
-                read_char();
+            if (pos != end && *pos == '.') {
+                ++pos;
                 read_digits();
                 is_int = false;
             }
-
-            // Парсим экспоненциальную часть числа
-            if (int ch = input.peek(); ch == 'e' || ch == 'E') {
-                read_char();
-                if (ch = input.peek(); ch == '+' || ch == '-') {
-                    read_char();
+            if (pos != end && (*pos == 'e' || *pos == 'E')) {
+                ++pos;
+                if (pos != end && (*pos == '+' || *pos == '-')) {
+                    ++pos;
                 }
                 read_digits();
                 is_int = false;
             }
 
-            try {
-                if (is_int) {
-                    // Сначала пробуем преобразовать строку в int
-                    try {
-                        return Node(std::stoi(parsed_num));
-                    } catch (...) {
-                        // В случае неудачи, например, при переполнении,
-                        // код ниже попробует преобразовать строку в double
-                    }
+            if (pos != end) {
+                throw ParsingError("Failed to convert "s + std::string(token) + " to number"s);
+            }
+            if (is_int) {
+                int value;
+                // on overflow the number is read as double below
+                if (const auto [ptr, ec] = std::from_chars(token.data(), end, value); ec == std::errc()) {
+                    return Node(value);
                 }
-                return Node(std::stod(parsed_num));
-            } catch (...) {
-                throw ParsingError("Failed to convert "s + parsed_num + " to number"s);
             }
+            // exact and locale independent, unlike strtod
+            double value;
+            if (const auto [ptr, ec] = std::from_chars(token.data(), end, value); ec != std::errc() || ptr != end) {
+                throw ParsingError("Failed to convert "s + std::string(token) + " to number"s);
+            }
+            return Node(value);
         }
 
-        Node LoadBool(std::istream& input) {
-            std::string check;
-            check.reserve(5);
-            char c;
-
-            while(check.size()<4 && input >> c) {
-                check += c;
+        // The second stage, see BuildStructuralIndex()
+        class IndexParser {
+        public:
+            // arrays, dictionaries and strings are allocated from resource
+            IndexParser(std::string_view input, const std::vector<uint32_t>& index, std::pmr::memory_resource* resource)
+                    : input_(input)
+                    , index_(index)
+                    , resource_(resource) {
             }
 
-            if(check.size() < 4) {
-                throw ParsingError("Failed to read bool value. EOF!"s);
+            Node LoadNode() {
+                if (next_ == index_.size()) {
+                    throw ParsingError("Unexpected EOF"s);
+                }
+
+                const size_t pos = index_[next_++];
+                switch (input_[pos]) {
+                    case '[':
+                        return LoadArray();
+                    case '{':
+                        return LoadDict();
+                    case '"':
+                        return Node(LoadString(pos, String(resource_)));
+                    case ']': case '}': case ',': case ':':
+                        throw ParsingError("Unexpected symbol "s + input_[pos]);
+                    default:
+                        return LoadScalar(pos);
+                }
             }
 
-            bool result;
-            if (check == "true"s) {
-                result = true;
-            } else {
-                if ( !(input >> c) ) {
-                    throw ParsingError("Failed to read bool value. EOF!"s);
+            // The same walk as LoadNode(), giving out events instead of nodes
+            void EmitNode(Handler& handler) {
+                if (next_ == index_.size()) {
+                    throw ParsingError("Unexpected EOF"s);
                 }
-                check += c;
-                if (check != "false"s) {
-                    cerr << "Data>>"s << check << "<<"s << endl;
-                    throw ParsingError("Failed to read bool value. Incorrect symbols presented."s);
+
+                const size_t pos = index_[next_++];
+                switch (input_[pos]) {
+                    case '[':
+                        EmitArray(handler);
+                        break;
+                    case '{':
+                        EmitDict(handler);
+                        break;
+                    case '"':
+                        handler.Value(Node(LoadString(pos, String(resource_))));
+                        break;
+                    case ']': case '}': case ',': case ':':
+                        throw ParsingError("Unexpected symbol "s + input_[pos]);
+                    default:
+                        handler.Value(LoadScalar(pos));
                 }
-                result = false;
             }
 
-            return Node(result);
-        }
+        private:
+            std::string_view input_;
+            const std::vector<uint32_t>& index_;
+            std::pmr::memory_resource* resource_;
+            std::vector<Node> array_stack_;
+            std::vector<Dict::value_type> dict_stack_;
+            size_t next_ = 0;
+
+            // the next structural symbol, 0 at EOF
+            char Peek() const {
+                return next_ == index_.size() ? '\0' : input_[index_[next_]];
+            }
 
-        Node LoadNull(std::istream& input) {
-            std::string check;
-            check.reserve(5);
-            char c;
+            // Items are gathered on the stacks shared by all levels, then moved to the arena at once
+            // with the exact size, so the arena keeps no outgrown copies.
+            Node LoadArray() {
+                const size_t first = array_stack_.size();
 
-            while(check.size()<4 && input >> c) {
-                check += c;
+                if (Peek() == ']') {
+                    ++next_;
+                } else {
+                    while (true) {
+                        array_stack_.push_back(LoadNode());
+                        const char c = Peek();
+                        if (c == ']') {
+                            ++next_;
+                            break;
+                        }
+                        if (c != ',') {
+                            throw ParsingError(c == '\0' ? "Error loading array. Unexpected EOF."s
+                                                         : "Error loading array. ',' or ']' is expected."s);
+                        }
+                        ++next_;
+                    }
+                }
+
+                Array result(resource_);
+                result.reserve(array_stack_.size() - first);
+                move(array_stack_.begin() + first, array_stack_.end(), back_inserter(result));
+                array_stack_.resize(first);
+                return Node(move(result));
             }
 
-            if (check.size() < 4) {
-                throw ParsingError("Failed to read null value. EOF!"s);
+            Node LoadDict() {
+                const size_t first = dict_stack_.size();
+
+                if (Peek() == '}') {
+                    ++next_;
+                } else {
+                    while (true) {
+                        if (Peek() != '"') {
+                            throw ParsingError("Error while loading dictionary. A key is expected."s);
+                        }
+                        String key = LoadString(index_[next_++], String(resource_));
+                        if (Peek() != ':') {
+                            throw ParsingError("Error while loading dictionary. ':' is expected."s);
+                        }
+                        ++next_;
+                        Node value = LoadNode();
+                        dict_stack_.emplace_back(move(key), move(value));
+
+                        const char c = Peek();
+                        if (c == '}') {
+                            ++next_;
+                            break;
+                        }
+                        if (c != ',') {
+                            throw ParsingError(c == '\0' ? "Error while loading dictionary. Unexpected EOF."s
+                                                         : "Error while loading dictionary. ',' or '}' is expected."s);
+                        }
+                        ++next_;
+                    }
+                }
+
+                Dict::Storage items(resource_);
+                items.reserve(dict_stack_.size() - first);
+                move(dict_stack_.begin() + first, dict_stack_.end(), back_inserter(items));
+                dict_stack_.resize(first);
+                return Node(Dict(move(items)));
             }
-            if (check != "null"s) {
-                throw ParsingError("Failed to read null value. Incorrect symbols presented."s);
+
+            void EmitArray(Handler& handler) {
+                handler.StartArray();
+
+                if (Peek() == ']') {
+                    ++next_;
+                    handler.EndArray();
+                    return;
+                }
+                while (true) {
+                    EmitNode(handler);
+                    const char c = Peek();
+                    if (c == ']') {
+                        ++next_;
+                        break;
+                    }
+                    if (c != ',') {
+                        throw ParsingError(c == '\0' ? "Error loading array. Unexpected EOF."s
+                                                     : "Error loading array. ',' or ']' is expected."s);
+                    }
+                    ++next_;
+                }
+
+                handler.EndArray();
             }
 
-            return Node(nullptr);
-        }
+            void EmitDict(Handler& handler) {
+                handler.StartDict();
 
+                if (Peek() == '}') {
+                    ++next_;
+                    handler.EndDict();
+                    return;
+                }
+                while (true) {
+                    if (Peek() != '"') {
+                        throw ParsingError("Error while loading dictionary. A key is expected."s);
+                    }
+                    handler.Key(LoadString(index_[next_++], std::string()));
+                    if (Peek() != ':') {
+                        throw ParsingError("Error while loading dictionary. ':' is expected."s);
+                    }
+                    ++next_;
+                    EmitNode(handler);
 
+                    const char c = Peek();
+                    if (c == '}') {
+                        ++next_;
+                        break;
+                    }
+                    if (c != ',') {
+                        throw ParsingError(c == '\0' ? "Error while loading dictionary. Unexpected EOF."s
+                                                     : "Error while loading dictionary. ',' or '}' is expected."s);
+                    }
+                    ++next_;
+                }
+
+                handler.EndDict();
+            }
 
-        Node LoadNode(std::istream& input) {
-            char c;
+            // open is the opening quote, the closing one is always the next in the index.
+            // The text goes to s, so that it takes the allocator of s.
+            template <typename Str>
+            Str LoadString(size_t open, Str s) {
+                const size_t close = index_[next_++];
+                const std::string_view body = input_.substr(open + 1, close - open - 1);
+                if (std::memchr(body.data(), '\\', body.size()) == nullptr) {
+                    // nothing to unescape, the common case
+                    s.assign(body);
+                } else {
+                    Unescape(body, s);
+                }
+                return s;
+            }
 
-            FlushSkipSymbols(input); // start of node reading
+            Node LoadScalar(size_t start) {
+                size_t end = next_ == index_.size() ? input_.size() : index_[next_];
+                while (end > start && IsSkipSymbol(input_[end - 1])) {
+                    --end;
+                }
+                const std::string_view token = input_.substr(start, end - start);
+
+                switch (token.front()) {
+                    case 't':
+                        CheckWord(token, "true"sv);
+                        return Node(true);
+                    case 'f':
+                        CheckWord(token, "false"sv);
+                        return Node(false);
+                    case 'n':
+                        CheckWord(token, "null"sv);
+                        return Node(nullptr);
+                    default:
+                        return ParseNumber(token);
+                }
+            }
 
-            input >> c;
-            if (c == '[') {
-                return LoadArray(input);
-            } else if (c == '{') {
-                return LoadDict(input);
-            } else if (c == '"') {
-                return LoadString(input);
-            } else if (c == 't' || c == 'f') {
-                input.putback(c);
-                return LoadBool(input);
-            } else if (c == 'n') {
-                input.putback(c);
-                return LoadNull(input);
-            } else {
-                input.putback(c);
-                return LoadNumber(input);
+            static void CheckWord(std::string_view token, std::string_view word) {
+                if (token != word) {
+                    throw ParsingError("Failed to read "s + std::string(word) + " value. Incorrect symbols presented."s);
+                }
             }
-        }
+        };
 
     }  // namespace
 
@@ -321,11 +540,11 @@ namespace json {
         return std::get<int>(*this);
     }
 
-    const string& Node::AsString() const {
+    const String& Node::AsString() const {
         if (! IsString()) {
             throw std::logic_error("Node value is not string.");
         }
-        return std::get<std::string>(*this);
+        return std::get<String>(*this);
     }
 
     bool Node::AsBool() const {
@@ -365,7 +584,7 @@ namespace json {
     }
 
     bool Node::IsString() const {
-        return std::holds_alternative<std::string>(*this);
+        return std::holds_alternative<String>(*this);
     }
 
     bool Node::IsNull() const {
@@ -380,10 +599,94 @@ namespace json {
         return std::holds_alternative<Dict>(*this);
     }
 
+    Dict::Dict(std::pmr::memory_resource* resource)
+            : items_(resource) {
+    }
+
+    Dict::Dict(Storage&& items)
+            : items_(move(items)) {
+        const auto by_key = [](const value_type& lhs, const value_type& rhs) {
+            return lhs.first < rhs.first;
+        };
+        if (items_.size() <= 16) {
+            // insertion sort: stable and allocates nothing, which suits the usual small dictionaries
+            for (auto iter = items_.begin(); iter != items_.end(); ++iter) {
+                auto place = upper_bound(items_.begin(), iter, *iter, by_key);
+                rotate(place, iter, iter + 1);
+            }
+        } else if (!is_sorted(items_.begin(), items_.end(), by_key)) {
+            stable_sort(items_.begin(), items_.end(), by_key);
+        }
+        items_.erase(unique(items_.begin(), items_.end(), [](const value_type& lhs, const value_type& rhs) {
+            return lhs.first == rhs.first;
+        }), items_.end());
+    }
+
+    size_t Dict::size() const {
+        return items_.size();
+    }
+
+    Dict::iterator Dict::find(std::string_view key) {
+        const auto iter = lower_bound(items_.begin(), items_.end(), key, [](const value_type& item, std::string_view key) {
+            return item.first < key;
+        });
+        return iter != items_.end() && iter->first == key ? iter : items_.end();
+    }
+
+    Dict::const_iterator Dict::find(std::string_view key) const {
+        return const_cast<Dict*>(this)->find(key);
+    }
+
+    size_t Dict::count(std::string_view key) const {
+        return find(key) == end() ? 0 : 1;
+    }
+
+    const Node& Dict::at(std::string_view key) const {
+        const auto iter = find(key);
+        if (iter == end()) {
+            throw std::out_of_range("No key "s + std::string(key) + " in the dictionary"s);
+        }
+        return iter->second;
+    }
+
+    Node& Dict::at(std::string_view key) {
+        return const_cast<Node&>(static_cast<const Dict&>(*this).at(key));
+    }
+
+    std::pair<Dict::iterator, bool> Dict::emplace(std::string_view key, Node value) {
+        const auto iter = lower_bound(items_.begin(), items_.end(), key, [](const value_type& item, std::string_view key) {
+            return item.first < key;
+        });
+        if (iter != items_.end() && iter->first == key) {
+            return {iter, false};
+        }
+        return {items_.emplace(iter, key, move(value)), true};
+    }
+
+    bool Dict::operator==(const Dict& other) const {
+        return items_ == other.items_;
+    }
+
+    bool Dict::operator!=(const Dict& other) const {
+        return !(*this == other);
+    }
+
     Document::Document(Node root)
             : root_(move(root)) {
     }
 
+    Document::Document(Node root, std::shared_ptr<std::pmr::memory_resource> arena)
+            : arena_(move(arena))
+            , root_(move(root)) {
+    }
+
+    Document& Document::operator=(Document other) {
+        root_ = nullptr;
+        arena_ = move(other.arena_);
+        root_ = move(other.root_);
+        return *this;
+    }
+
     const Node& Document::GetRoot() const {
         return root_;
     }
@@ -397,8 +700,38 @@ namespace json {
     }
 
 
+    namespace {
+
+        string ReadAll(istream& input) {
+            string buffer;
+            char chunk[1 << 16];
+            while (input.read(chunk, sizeof(chunk)) || input.gcount() > 0) {
+                buffer.append(chunk, static_cast<size_t>(input.gcount()));
+            }
+            return buffer;
+        }
+
+    }  // namespace
+
     Document Load(istream& input) {
-        return Document{LoadNode(input)};
+        // the whole stream is read at once, then parsed from memory
+        return Load(string_view(ReadAll(input)));
+    }
+
+    Document Load(string_view input) {
+        const std::vector<uint32_t> index = BuildStructuralIndex(input);
+        auto arena = std::make_shared<std::pmr::monotonic_buffer_resource>(input.size());
+        Node root = IndexParser(input, index, arena.get()).LoadNode();
+        return Document{move(root), move(arena)};
+    }
+
+    void Parse(istream& input, Handler& handler) {
+        Parse(string_view(ReadAll(input)), handler);
+    }
+
+    void Parse(string_view input, Handler& handler) {
+        const std::vector<uint32_t> index = BuildStructuralIndex(input);
+        IndexParser(input, index, std::pmr::get_default_resource()).EmitNode(handler);
     }
 
     void Print(const Document& doc, std::ostream& output) {
@@ -406,13 +739,32 @@ namespace json {
         PrintNode(doc.GetRoot(), context);
     }
 
+    char* FormatNumber(double value, char* buffer) {
+        // shortest text that reads back as the same double
+        return std::to_chars(buffer, buffer + MAX_NUMBER_CHARS, value).ptr;
+    }
+
+    char* FormatNumber(int value, char* buffer) {
+        return std::to_chars(buffer, buffer + MAX_NUMBER_CHARS, value).ptr;
+    }
+
+    void PrintValue(int value, svg::RenderContext context) {
+        char buffer[MAX_NUMBER_CHARS];
+        context.out.write(buffer, FormatNumber(value, buffer) - buffer);
+    }
+
+    void PrintValue(double value, svg::RenderContext context) {
+        char buffer[MAX_NUMBER_CHARS];
+        context.out.write(buffer, FormatNumber(value, buffer) - buffer);
+    }
+
     void PrintValue(std::nullptr_t, svg::RenderContext context) {
         ostream& out = context.out;
         out << "null"sv;
     }
 
 
-    void PrintValue(const string &str, svg::RenderContext context) {
+    void PrintValue(const String &str, svg::RenderContext context) {
         std::ostream& out = context.out;
         out << "\""sv;
 
@@ -452,7 +804,7 @@ namespace json {
 
     void PrintValue(const Array &arr, svg::RenderContext context) {
         std::ostream& out = context.out;
-        out << "["sv << endl;
+        out << "["sv << '\n';
         auto indent = context.Indented();
         for (auto iter = arr.begin(); iter != arr.end(); ++iter) {
             indent.RenderIndent();
@@ -460,7 +812,7 @@ namespace json {
             if (std::next(iter) != arr.end()) {
                 out << ","sv;
             }
-            out << endl;
+            out << '\n';
         }
         context.RenderIndent();
         out << "]"sv;
@@ -469,7 +821,7 @@ namespace json {
     void PrintValue(const Dict &dict, svg::RenderContext context) {
         std::ostream& out = context.out;
         auto indent = context.Indented();
-        out << "{"sv << endl;
+        out << "{"sv << '\n';
         for (auto iter = dict.begin(); iter != dict.end(); ++iter) {
             indent.RenderIndent();
             out << "\""sv << iter->first << "\": "sv;
@@ -477,7 +829,7 @@ namespace json {
             if (std::next(iter) != dict.end() ) {
                 out << ","sv;
             }
-            out << endl;
+            out << '\n';
         }
         context.RenderIndent();
         out << "}";
@@ -1,8 +1,10 @@
 #pragma once
 
 #include <iostream>
-#include <map>
+#include <memory>
+#include <memory_resource>
 #include <string>
+#include <string_view>
 #include <utility>
 #include <vector>
 #include <variant>
@@ -12,11 +14,47 @@ namespace json {
 
     class Node;
 
-    using Dict = std::map<std::string, Node>;
-    using Array = std::vector<Node>;
+    // Arrays, dictionaries, strings and keys of a parsed document take their memory from the arena
+    // of the document, the ones made elsewhere from the heap. Copies always go to the heap.
+    using Array = std::pmr::vector<Node>;
+    using String = std::pmr::string;
 
-    Node LoadNumber(std::istream& input);
-    Node LoadString(std::istream& input);
+    // Key/value pairs sorted by key in one array, with the part of the std::map interface the readers use.
+    // Dictionaries of JSON are small and read much more often than built, so a binary search over
+    // contiguous pairs wins over a tree of separately allocated nodes.
+    class Dict {
+    public:
+        using value_type = std::pair<String, Node>;
+        using Storage = std::pmr::vector<value_type>;
+        using iterator = Storage::iterator;
+        using const_iterator = Storage::const_iterator;
+
+        Dict() = default;
+        explicit Dict(std::pmr::memory_resource* resource);
+        // pairs in any order; of repeated keys the first one stays, as with std::map::emplace
+        explicit Dict(Storage&& items);
+
+        iterator begin() { return items_.begin(); }
+        iterator end() { return items_.end(); }
+        const_iterator begin() const { return items_.begin(); }
+        const_iterator end() const { return items_.end(); }
+        size_t size() const;
+        bool empty() const { return items_.empty(); }
+
+        iterator find(std::string_view key);
+        const_iterator find(std::string_view key) const;
+        size_t count(std::string_view key) const;
+        const Node& at(std::string_view key) const;
+        Node& at(std::string_view key);
+
+        std::pair<iterator, bool> emplace(std::string_view key, Node value);
+
+        bool operator==(const Dict& other) const;
+        bool operator!=(const Dict& other) const;
+
+    private:
+        Storage items_;
+    };
 
 // Эта ошибка должна выбрасываться при ошибках парсинга JSON
     class ParsingError : public std::runtime_error {
@@ -25,11 +63,15 @@ namespace json {
     };
 
 
-    class Node : public std::variant<std::nullptr_t, int, double, std::string, bool, Array, Dict> {
+    class Node : public std::variant<std::nullptr_t, int, double, String, bool, Array, Dict> {
     public:
         using variant::variant;
         using Value = variant;
 
+        // strings made outside of the parser, e.g. std::string, go to the heap
+        Node(std::string_view value) : variant(String(value)) {
+        }
+
         const Value& GetValue() const {return *this;}
 
         bool IsInt() const;
@@ -44,7 +86,7 @@ namespace json {
         int AsInt() const;
         bool AsBool() const;
         double AsDouble() const;
-        const std::string& AsString() const;
+        const String& AsString() const;
         const Array& AsArray() const;
         const Dict& AsDict() const;
         Array& AsArray();
@@ -55,6 +97,13 @@ namespace json {
     class Document {
     public:
         explicit Document(Node root);
+        // the root and everything in it are allocated from arena
+        Document(Node root, std::shared_ptr<std::pmr::memory_resource> arena);
+
+        Document(const Document& other) = default;
+        Document(Document&& other) = default;
+        // nodes go before the arena they live in
+        Document& operator=(Document other);
 
         const Node& GetRoot() const;
 
@@ -62,10 +111,34 @@ namespace json {
         bool operator!=(const Document& other) const;
 
     private:
+        std::shared_ptr<std::pmr::memory_resource> arena_; // released in one go with the document
         Node root_;
     };
 
+    // Receives a document piece by piece, in document order, without building the tree.
+    // Every dictionary value comes right after its Key(). Scalars come as Value().
+    class Handler {
+    public:
+        virtual ~Handler() = default;
+
+        virtual void StartDict() = 0;
+        virtual void Key(std::string&& key) = 0;
+        virtual void EndDict() = 0;
+        virtual void StartArray() = 0;
+        virtual void EndArray() = 0;
+        virtual void Value(Node&& value) = 0;
+    };
+
+    // Malformed input throws ParsingError, a missing ',' between array items or dictionary
+    // entries included.
+    // Reads the whole stream and parses it as one document
     Document Load(std::istream& input);
+    // Parses a document held in memory, e.g. a whole file read or mapped at once.
+    // The input is not kept, strings are copied to the arena of the document.
+    Document Load(std::string_view input);
+    // Same as Load(), but the document goes to the handler instead of a tree
+    void Parse(std::istream& input, Handler& handler);
+    void Parse(std::string_view input, Handler& handler);
 
     void Print(const Document& doc, std::ostream& output);
 
@@ -75,7 +148,15 @@ namespace json {
         out << value;
     }
 
-    void PrintValue(const std::string& str, svg::RenderContext context);
+    // All numbers are written through these: the shortest text that reads back exactly.
+    // buffer must have room for MAX_NUMBER_CHARS, the end of the text is returned.
+    inline constexpr size_t MAX_NUMBER_CHARS = 32;
+    char* FormatNumber(double value, char* buffer);
+    char* FormatNumber(int value, char* buffer);
+
+    void PrintValue(int value, svg::RenderContext context);
+    void PrintValue(double value, svg::RenderContext context);
+    void PrintValue(const String& str, svg::RenderContext context);
     void PrintValue(std::nullptr_t, svg::RenderContext context);
     void PrintValue( bool val, svg::RenderContext context);
     void PrintValue(const Array& arr, svg::RenderContext context);
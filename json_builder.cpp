@@ -96,7 +96,7 @@ namespace json {
         }
 
         if ( Node* node = nodes_stack_.back(); node->IsString() ) { // this dict is a value in previously declared Dictionary.
-            std::string key = node->AsString();
+            std::string key(node->AsString());
             nodes_stack_.pop_back();
             delete node;
             node = nodes_stack_.empty() ? nullptr : nodes_stack_.back();
@@ -163,7 +163,7 @@ namespace json {
         }
 
         if ( Node* node = nodes_stack_.back(); node->IsString() ) { // this array is a value in previously declared Dictionary.
-            std::string key = node->AsString();
+            std::string key(node->AsString());
             nodes_stack_.pop_back();
             delete node;
             node = nodes_stack_.empty() ? nullptr : nodes_stack_.back();
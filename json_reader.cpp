@@ -1,5 +1,17 @@
 #include "json_reader.h"
+#include "base_requests_handler.h"
 #include "json_builder.h"
+#include "json_writer.h"
+#include "repeated_requests.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <thread>
 
 
 
@@ -22,50 +34,38 @@ size_t JsonReader::ReadJson(std::istream &input) {
 }
 
 size_t JsonReader::ReadJsonToTransportCatalogue(std::istream &input) {
-    size_t check_num = ReadJson(input);
-    if (check_num == 0) return check_num;
+    // base_requests go from the parser straight to the bulk loader, without the tree
+    BaseRequestsHandler handler(raw_stops_, raw_buses_);
+    try {
+        json::Parse(input, handler);
+    } catch (const json::ParsingError& e) {
+        std::cerr << e.what() << std::endl;
+        raw_stops_.clear();
+        raw_buses_.clear();
+        return 0;
+    }
+    if (!handler.IsRootDict() || handler.GetRootSize() == 0) return 0;
 
-    size_t result = ParseJsonToRawData();
+    root_.emplace_back(json::Node(handler.TakeOtherSections()));
+    if (!handler.HasBaseRequests()) {
+        throw json::ParsingError("Error reading JSON data for database filling 02.");
+    }
+    if (handler.HasBadEntries()) {
+        throw json::ParsingError("Error reading JSON data for database filling 03.");
+    }
+    const size_t result = handler.GetEntriesCount();
 
     FillTransportCatalogue();
 
     routing_settings_ = GetRoutingSettings();
-    graph_ptr_ = std::make_unique<TransportCatalogueRouterGraph>(transport_catalogue_, routing_settings_.value());
-
-    return result;
-}
-
-size_t JsonReader::ParseJsonToRawData() {
-    size_t result = 0;
-
-    const json::Node& root_node = root_.back().GetRoot();
-    if (!root_node.IsDict()) {
-        throw json::ParsingError("Error reading JSON data for database filling 01.");
-    }
-    const json::Dict& dict = root_node.AsDict();
-    auto iter = dict.find(BASE_DATA);
-    if (iter == dict.end() || !(iter->second.IsArray()) ) {
-        throw json::ParsingError("Error reading JSON data for database filling 02.");
-    }
-
-    const json::Array& nodes = iter->second.AsArray();
-    for (const auto& node : nodes) {
-        using namespace transport_catalogue;
-        BaseRequest data = std::move(ParseDataNode(node));
-        if (auto* stop = std::get_if<StopWithDistances>(&data)) {
-            raw_stops_.emplace_back(std::move(*stop));
-        } else if (auto* bus = std::get_if<BusRouteJson>(&data) ) {
-            raw_buses_.emplace_back(std::move(*bus));
-        } else {
-            throw json::ParsingError("Error reading JSON data for database filling 03.");
-        }
-        ++result;
-    }
+    graph_ptr_ = std::make_shared<TransportCatalogueRouterGraph>(transport_catalogue_, routing_settings_.value());
+    spatial_ptr_ = std::make_shared<transport_catalogue::StopsSpatialIndex>(transport_catalogue_);
+    own_version_.reset();
 
     return result;
 }
 
-BaseRequest JsonReader::ParseDataStop(const json::Dict& dict) const {
+BaseRequest JsonReader::ParseDataStop(const json::Dict& dict, bool with_coordinates) const {
     using namespace transport_catalogue;
     StopWithDistances stop;
     stop.id = 0;
@@ -76,17 +76,20 @@ BaseRequest JsonReader::ParseDataStop(const json::Dict& dict) const {
         return {};
     }
 
-    if (const auto coords = ParseCoordinates(dict); coords ) {
+    if (!with_coordinates) {
+        // distances only, for a stop that exists already
+    } else if (const auto coords = ParseCoordinates(dict); coords ) {
         stop.coordinates = coords.value();
     } else {
         return {};
     }
 
     const auto dist_i = dict.find("road_distances"s);
-    if (dist_i != dict.end() && !(dist_i->second.IsDict())) return {}; // проверка, что это словарь. он необязательный для остановки.
+    if (dist_i == dict.end()) return {stop}; // он необязательный для остановки.
+    if (!(dist_i->second.IsDict())) return {}; // проверка, что это словарь.
     for (const auto& [other_name, other_dist] : dist_i->second.AsDict()) {
         if (!other_dist.IsInt()) return {};
-        stop.distances.emplace_back(StopDistanceData{other_name, static_cast<size_t>(other_dist.AsInt())});
+        stop.distances.emplace_back(StopDistanceData{std::string(other_name), static_cast<size_t>(other_dist.AsInt())});
     }
     return {stop};
 }
@@ -107,7 +110,7 @@ BaseRequest JsonReader::ParseDataBus(const json::Dict& dict) const {
     }
 
     const auto stops_i = dict.find("stops"s);
-    if (stops_i != dict.end() && !(stops_i->second.IsArray())) return {};
+    if (stops_i == dict.end() || !(stops_i->second.IsArray())) return {};
     for (const auto& stop_name : stops_i->second.AsArray()) {
         if (!stop_name.IsString()) return {};
         route.route_stops.emplace_back(stop_name.AsString());
@@ -154,45 +157,34 @@ std::optional<geo::Coordinates> JsonReader::ParseCoordinates(const json::Dict& d
 
 
 bool JsonReader::FillTransportCatalogue() {
-
-    // fill stops data to catalogue
-    for (const auto& stop : raw_stops_) {
-        transport_catalogue_.AddStop(stop);
-    }
-
-    // fill stop distances to catalogue
-    for (const auto& stop : raw_stops_) {
-        for (const auto& [other, distance] : stop.distances) {
-            bool pairOK = transport_catalogue_.SetDistanceBetweenStops(stop.stop_name, other, distance);
-            if ( !pairOK ) {
-                std::cerr << "ERROR while adding distance to stop pair of "s << stop.stop_name << " and "s << other << "." << std::endl;
-            }
-        }
+    // bus routes must have at least 2 stops, the rest goes to the catalogue as is
+    auto bad_route = std::remove_if(raw_buses_.begin(), raw_buses_.end(), [](const BusRouteJson& route) {
+        if (route.route_stops.size() >= 2) return false;
+        std::cerr << "Error while adding bus routes for bus: "s << route.bus_name << ". Number of stops must be at least 2." << std::endl;
+        return true;
+    });
+    raw_buses_.erase(bad_route, raw_buses_.end());
+
+    const size_t rejected = transport_catalogue_.BulkLoad(std::move(raw_stops_), std::move(raw_buses_));
+    raw_stops_.clear();
+    raw_buses_.clear();
+    if (rejected > 0) {
+        std::cerr << "ERROR while filling the catalogue, "s << rejected << " entries rejected." << std::endl;
     }
 
-    // fill bus routes data to catalogue
-    for (auto& route : raw_buses_) {
-
-        if (route.route_stops.size() < 2) {
-            std::cerr << "Error while adding bus routes for bus: "s << route.bus_name << ". Number of stops must be at least 2." << std::endl;
-            continue;
-        }
-        transport_catalogue::BusRoute br;
-        br.bus_name = route.bus_name; // = std::move(route.bus_name);
-        br.type = route.type;
-        for (auto& route_stop : route.route_stops) {
-            br.route_stops.emplace_back( &(transport_catalogue_.FindStop(route_stop).second) );
-        }
+    return rejected == 0;
+}
 
-        transport_catalogue_.AddBus(br);
-    }
 
-    return true;
+size_t JsonReader::QueryTcWriteJsonToStream(std::ostream &out, size_t threads) {
+    return WriteResponses(root_.back().GetRoot(), out, threads);
 }
 
+size_t JsonReader::AnswerBatch(const json::Node &batch, std::ostream &out, size_t threads) {
+    return WriteResponses(batch, out, threads);
+}
 
-size_t JsonReader::QueryTcWriteJsonToStream(std::ostream &out) {
-    const auto& root_node = root_.back().GetRoot();
+size_t JsonReader::WriteResponses(const json::Node &root_node, std::ostream &out, size_t threads) {
     if (!root_node.IsDict()) {
         throw json::ParsingError("Error reading JSON data with user requests to database.");
     }
@@ -203,23 +195,173 @@ size_t JsonReader::QueryTcWriteJsonToStream(std::ostream &out) {
         throw json::ParsingError("Error reading JSON data with user requests to database.");
     }
 
-    json::Builder builder;
-    builder.StartArray();
+    // the whole batch is answered from the same version, even if a newer one is published meanwhile
+    const auto version = CurrentVersion();
 
-    for (const json::Node& node : iter->second.AsArray()) {
-        if (!node.IsDict()) {
-            throw json::ParsingError("Error reading JSON data with user requests to database. One of nodes is not a dictionary.");
+    // every response is written out as soon as it is ready, nothing of it is kept afterwards
+    json::Writer writer(out);
+    writer.StartArray();
+
+    const json::Array& requests = iter->second.AsArray();
+    RepeatedRequests repeated(requests);
+    if (threads > 1 && requests.size() > 1) {
+        AnswerInParallel(requests, *version, threads, repeated, writer);
+    } else {
+        for (size_t i = 0; i < requests.size(); ++i) {
+            if (repeated.IsRepeat(i) && repeated.WriteRepeat(i, writer)) {
+                ++request_counters_.reused;
+            } else if (repeated.HasRepeats(i)) {
+                json::Writer response_writer(1);
+                ProcessOneUserRequest(requests[i], *version, response_writer);
+                repeated.Keep(i, response_writer.GetText());
+                writer.Raw(response_writer.GetText());
+            } else {
+                ProcessOneUserRequest(requests[i], *version, writer);
+            }
+            ++request_counters_.requests;
+        }
+    }
+    writer.EndArray();
+    writer.Flush();
+
+    return requests.size();
+}
+
+namespace {
+
+// Threads started once and given one task after another. Every task runs on all of them and on the
+// thread that calls Run(); Run() returns when all of them are done with it.
+class BatchWorkers {
+public:
+    explicit BatchWorkers(size_t count) {
+        threads_.reserve(count);
+        for (size_t i = 0; i < count; ++i) {
+            threads_.emplace_back([this]() { Work(); });
+        }
+    }
+
+    BatchWorkers(const BatchWorkers&) = delete;
+    BatchWorkers& operator=(const BatchWorkers&) = delete;
+
+    ~BatchWorkers() {
+        {
+            std::lock_guard lock(mutex_);
+            stop_ = true;
         }
+        task_ready_.notify_all();
+        for (std::thread& thread : threads_) {
+            thread.join();
+        }
+    }
+
+    // the task must not throw
+    void Run(const std::function<void()>& task) {
+        {
+            std::lock_guard lock(mutex_);
+            task_ = &task;
+            ++round_;
+            running_ = threads_.size();
+        }
+        task_ready_.notify_all();
+
+        task();
 
-        builder.Value(std::move(ProcessOneUserRequestNode(node)));
+        std::unique_lock lock(mutex_);
+        task_done_.wait(lock, [this]() { return running_ == 0; });
+        task_ = nullptr;
     }
-    json::Node res_node = builder.EndArray().Build();
 
-    svg::RenderContext context(out, 4, 0);
-    context.RenderIndent();
-    json::PrintNode(res_node, context);
+private:
+    std::vector<std::thread> threads_;
+    std::mutex mutex_;
+    std::condition_variable task_ready_;
+    std::condition_variable task_done_;
+    const std::function<void()>* task_ = nullptr;
+    uint64_t round_ = 0; // number of the last task given
+    size_t running_ = 0; // threads still busy with it
+    bool stop_ = false;
+
+    void Work() {
+        uint64_t done_round = 0;
+        std::unique_lock lock(mutex_);
+        while (true) {
+            task_ready_.wait(lock, [&]() { return stop_ || round_ != done_round; });
+            if (stop_) return;
+
+            done_round = round_;
+            const std::function<void()>& task = *task_;
+            lock.unlock();
+            task();
+            lock.lock();
+            if (--running_ == 0) {
+                task_done_.notify_one();
+            }
+        }
+    }
+};
+
+}  // namespace
+
+void JsonReader::AnswerInParallel(const json::Array& requests, const CatalogueVersion& version, size_t threads,
+                                  RepeatedRequests& repeated, json::Writer& writer) {
+    // Requests go in windows: the threads take requests of a window one by one, every thread writes
+    // into its own buffer and keeps the text by request; then the window goes out in order.
+    // Only one window of responses is kept at a time. The threads are started once for the batch.
+    const size_t window_size = threads * 64;
+    std::vector<std::string> responses(std::min(window_size, requests.size()));
+    std::vector<std::exception_ptr> errors(responses.size());
+
+    size_t window_start = 0;
+    size_t window_end = 0;
+    std::atomic<size_t> next = 0;
+    const std::function<void()> answer = [&]() {
+        // responses are items of the top-level array
+        json::Writer response_writer(1);
+        for (size_t i = next++; i < window_end; i = next++) {
+            // answered from the text of the earlier request when the window goes out
+            if (repeated.IsRepeat(i)) continue;
+            try {
+                ProcessOneUserRequest(requests[i], version, response_writer);
+                responses[i - window_start] = response_writer.GetText();
+            } catch (...) {
+                errors[i - window_start] = std::current_exception();
+            }
+            response_writer.Clear();
+        }
+    };
+
+    BatchWorkers workers(threads - 1);
+    for (; window_start < requests.size(); window_start += window_size) {
+        window_end = std::min(window_start + window_size, requests.size());
+        next = window_start;
+        workers.Run(answer);
+
+        // the same output as one thread gives: everything up to the first failed request
+        for (size_t i = 0; i < window_end - window_start; ++i) {
+            const size_t index = window_start + i;
+            ++request_counters_.requests;
+            if (repeated.IsRepeat(index)) {
+                if (repeated.WriteRepeat(index, writer)) {
+                    ++request_counters_.reused;
+                } else {
+                    ProcessOneUserRequest(requests[index], version, writer);
+                }
+                continue;
+            }
+            if (errors[i]) {
+                writer.Flush();
+                std::rethrow_exception(errors[i]);
+            }
+            writer.Raw(responses[i]);
+            if (repeated.HasRepeats(index)) {
+                repeated.Keep(index, responses[i]);
+            }
+        }
+    }
+}
 
-    return res_node.AsArray().size();
+RequestCounters JsonReader::GetRequestCounters() const {
+    return request_counters_;
 }
 
 size_t JsonReader::ReadJsonQueryTcWriteJsonToStream(std::istream &input, std::ostream &out) {
@@ -227,7 +369,50 @@ size_t JsonReader::ReadJsonQueryTcWriteJsonToStream(std::istream &input, std::os
     return QueryTcWriteJsonToStream(out);
 }
 
-json::Node JsonReader::ProcessOneUserRequestNode(const json::Node &user_request) {
+size_t JsonReader::AnswerRequestLines(std::istream &input, std::ostream &out) {
+    json::Writer writer(out, 1 << 16, json::Writer::Layout::COMPACT);
+
+    // the response of a line is gathered aside, so a request that fails halfway leaves nothing of it
+    json::Writer response(0, json::Writer::Layout::COMPACT);
+    size_t count = 0;
+    std::string line;
+    while (std::getline(input, line)) {
+        if (line.find_first_not_of(" \t\r"sv) == std::string::npos) continue;
+
+        response.Clear();
+        std::optional<int> id;
+        try {
+            const json::Document doc = json::Load(std::string_view(line));
+            const json::Node& root = doc.GetRoot();
+            if (root.IsDict()) {
+                if (const auto id_i = root.AsDict().find("id"s); id_i != root.AsDict().end() && id_i->second.IsInt()) {
+                    id = id_i->second.AsInt();
+                }
+            }
+            // every line is a batch of its own, so a newly published version is picked up by the next line
+            ProcessOneUserRequest(root, *CurrentVersion(), response);
+            ++count;
+            ++request_counters_.requests;
+        } catch (const std::exception& e) {
+            // wrong field types and missing fields included, the next lines are answered all the same
+            std::cerr << e.what() << std::endl;
+            response.Clear();
+            response.StartDict().Key("error_message"sv).Value(e.what());
+            if (id) {
+                response.Key("request_id"sv).Value(*id);
+            }
+            response.EndDict();
+        }
+        writer.Raw(response.GetText());
+        writer.Flush();
+        out << '\n';
+        out.flush();
+    }
+
+    return count;
+}
+
+void JsonReader::ProcessOneUserRequest(const json::Node &user_request, const CatalogueVersion& version, json::Writer& writer) {
     using namespace transport_catalogue;
 
     if (!user_request.IsDict()) {
@@ -246,10 +431,10 @@ json::Node JsonReader::ProcessOneUserRequestNode(const json::Node &user_request)
     if ( type_i == request_fields.end() || !(type_i->second.IsString()) ){
         throw json::ParsingError("Error reading JSON data with user requests to database. One of node's fields is crippled.");
     }
-    std::string type = type_i->second.AsString();
+    std::string type(type_i->second.AsString());
 
     if ( type == "Map"s) {
-        return GenerateMapNode(id);
+        return WriteMapResponse(id, version, writer);
     }
 
     if ( type == "Route"s) {
@@ -265,7 +450,27 @@ json::Node JsonReader::ProcessOneUserRequestNode(const json::Node &user_request)
             throw json::ParsingError("Error reading JSON data with user requests to database. Route->to field is crippled.");
         }
 
-        return GenerateRouteNode(id, from_stop, to_stop);
+        return WriteRouteResponse(id, from_stop, to_stop, version, writer);
+    }
+
+    if (type == "NearestStops"s) {
+        return WriteNearestStopsResponse(id, request_fields, version, writer);
+    }
+
+    if (type == "StopsInRadius"s) {
+        return WriteStopsInRadiusResponse(id, request_fields, version, writer);
+    }
+
+    if (type == "StopsInArea"s) {
+        return WriteStopsInAreaResponse(id, request_fields, version, writer);
+    }
+
+    if (type == "Suggest"s) {
+        return WriteSuggestResponse(id, request_fields, version, writer);
+    }
+
+    if (type == "MemoryUsage"s) {
+        return WriteMemoryUsageResponse(id, version, writer);
     }
 
     std::string name;
@@ -276,65 +481,70 @@ json::Node JsonReader::ProcessOneUserRequestNode(const json::Node &user_request)
     }
 
     if ( type == "Bus"s) {
-        return GenerateBusNode(id, name);
+        return WriteBusResponse(id, name, version, writer);
     }
 
     if (type == "Stop"s) {
-        return GenerateStopNode(id, name);
+        return WriteStopResponse(id, name, version, writer);
     }
 
     throw json::ParsingError("Error reading JSON data with user requests to database. Node's type field contains invalid data.");
 }
 
-json::Node JsonReader::GenerateMapNode(int id) const {
-    RendererSettings rs = GetRendererSetting();
-    MapRenderer mr(rs);
+// Keys of every response go in sorted order, as json::Print would put them
+
+const std::string& JsonReader::GetMapJson(const CatalogueVersion& version) const {
+    std::call_once(version.map_rendered, [&]() {
+        const RendererSettings rs = version.renderer_settings ? version.renderer_settings.value() : GetRendererSetting();
+        MapRenderer mr(rs);
+
+        std::string text = "\""s;
+        {
+            json::EscapingStreamBuf escaping_buf(text);
+            std::ostream stream(&escaping_buf);
+            mr.RenderSvgMap(*version.catalogue, stream);
+        }
+        text += '"';
+        version.map_json = std::move(text);
+    });
 
-    std::ostringstream stream;
-    mr.RenderSvgMap(transport_catalogue_, stream);
+    return version.map_json;
+}
 
-    return json::Builder().StartDict().Key("request_id"s).Value(id).Key("map"s).Value(std::move(stream.str())).EndDict().Build();
+void JsonReader::WriteMapResponse(int id, const CatalogueVersion& version, json::Writer& writer) const {
+    writer.StartDict().Key("map"sv).Raw(GetMapJson(version)).Key("request_id"sv).Value(id).EndDict();
 }
 
-json::Node JsonReader::GenerateBusNode(int id, std::string& name) const {
+void JsonReader::WriteBusResponse(int id, std::string& name, const CatalogueVersion& version, json::Writer& writer) const {
     using namespace transport_catalogue;
 
-    BusInfo bi = transport_catalogue_.GetBusInfo(name);
+    BusInfo bi = version.catalogue->GetBusInfo(name);
     if (bi.type == RouteType::NOT_SET) {
-        return GetErrorNode(id);
+        return WriteErrorResponse(id, writer);
     }
 
-//    return json::Builder().StartDict().Key("request_id"s).Value(id).Key("curvature"s).Value(bi.curvature)
-//            .Key("route_length"s).Value(static_cast<int>(bi.route_length)).Key("stop_count"s).Value(static_cast<int>(bi.stops_number))
-//            .Key("unique_stop_count"s).Value(static_cast<int>(bi.unique_stops)).EndDict().Build();
-
-    return json::Builder().StartDict().Key("request_id"s).Value(id).Key("curvature"s).Value(bi.curvature)
-            .Key("route_length"s).Value(static_cast<double>(bi.route_length)).Key("stop_count"s).Value(static_cast<int>(bi.stops_number))
-            .Key("unique_stop_count"s).Value(static_cast<int>(bi.unique_stops)).EndDict().Build();
+    writer.StartDict().Key("curvature"sv).Value(bi.curvature).Key("request_id"sv).Value(id)
+            .Key("route_length"sv).Value(static_cast<double>(bi.route_length)).Key("stop_count"sv).Value(static_cast<int>(bi.stops_number))
+            .Key("unique_stop_count"sv).Value(static_cast<int>(bi.unique_stops)).EndDict();
 }
 
-json::Node JsonReader::GenerateStopNode(int id, std::string& name) const {
+void JsonReader::WriteStopResponse(int id, std::string& name, const CatalogueVersion& version, json::Writer& writer) const {
     using namespace transport_catalogue;
 
-    if ( ! transport_catalogue_.FindStop(name).first ) {
-        return GetErrorNode(id);
+    if ( ! version.catalogue->FindStop(name).first ) {
+        return WriteErrorResponse(id, writer);
     }
-    json::Dict result;
-    json::Array buses;
-    json::Builder builder;
-    builder.StartDict().Key("buses"s).StartArray();
-    const std::set<std::string_view>& bus_routes = transport_catalogue_.GetBusesForStop(name);
-    for (auto bus_route : bus_routes) {
-        builder.Value(std::move(std::string{bus_route}));
+    writer.StartDict().Key("buses"sv).StartArray();
+    for (const BusRoute* bus_route : version.catalogue->GetBusesForStop(name)) {
+        writer.Value(bus_route->bus_name);
     }
-    builder.EndArray();
-    builder.Key("request_id"s).Value(id).EndDict();
-
-    return builder.Build();
+    writer.EndArray();
+    writer.Key("request_id"sv).Value(id).EndDict();
 }
 
 
 RendererSettings JsonReader::GetRendererSetting() const {
+    std::lock_guard lock(settings_mutex_);
     if (renderer_settings_.has_value()) {
         return renderer_settings_.value();
     }
@@ -447,6 +657,7 @@ RendererSettings JsonReader::GetRendererSetting() const {
 }
 
 RoutingSettings JsonReader::GetRoutingSettings() const {
+    std::lock_guard lock(settings_mutex_);
     if (routing_settings_.has_value()) {
         return routing_settings_.value();
     }
@@ -480,52 +691,213 @@ RoutingSettings JsonReader::GetRoutingSettings() const {
     return settings;
 }
 
-json::Node JsonReader::GenerateRouteNode(int id, std::string_view from, std::string_view to) const {
-    const auto& [found_from, from_stop] = transport_catalogue_.FindStop(from);
-    const auto& [found_to, to_stop] = transport_catalogue_.FindStop(to);
+void JsonReader::WriteRouteResponse(int id, std::string_view from, std::string_view to, const CatalogueVersion& version,
+                                    json::Writer& writer) const {
+    const auto& [found_from, from_stop] = version.catalogue->FindStop(from);
+    const auto& [found_to, to_stop] = version.catalogue->FindStop(to);
+    const auto& graph = *version.graph;
     if (!found_from || !found_to) {
         throw json::ParsingError("Error while parsing routing request, stops not found.");
     }
 
-    auto route = graph_ptr_->BuildRoute(from, to);
+    auto route = graph.BuildRoute(from, to);
     if (!route) {
-        return GetErrorNode(id);
+        return WriteErrorResponse(id, writer);
     }
 
-    json::Builder builder;
-    builder.StartDict().Key("request_id"s).Value(id).Key("total_time"s).Value(route->weight).Key("items"s).StartArray();
+    writer.StartDict().Key("items"sv).StartArray();
 
-
-    double waiting_time = graph_ptr_->GetBusWaitingTime();
-    // int bus_count = 0;
+    double waiting_time = graph.GetBusWaitingTime();
 
     for (const auto& edge_id : route->edges) {
-        const graph::Edge<double>& edge = graph_ptr_->GetEdge(edge_id);
-
-        auto link = graph_ptr_->GetLinkById(edge_id);
-        const auto& stop_from = graph_ptr_->GetStopById(edge.from);
-        //const auto& stop_to = graph_ptr_->GetStopById(edge.to);
+        const graph::Edge<double>& edge = graph.GetEdge(edge_id);
 
-        json::Builder wait_builder;
-        wait_builder.StartDict().Key("type"s).Value("Wait"s)
-        .Key("stop_name"s).Value(std::string{stop_from.stop_name})
-        .Key("time"s).Value(waiting_time).EndDict();
-        builder.Value(std::move(wait_builder.Build()));
+        auto link = graph.GetLinkById(edge_id);
+        const auto& stop_from = graph.GetStopById(edge.from);
 
+        writer.StartDict().Key("stop_name"sv).Value(stop_from.stop_name)
+                .Key("time"sv).Value(waiting_time).Key("type"sv).Value("Wait"sv).EndDict();
 
-        json::Builder bus_builder;
         double time = edge.weight - waiting_time;
-        bus_builder.StartDict().Key("type"s).Value("Bus"s).Key("bus"s).Value(std::string{link.bus_name})
-                .Key("span_count"s).Value(static_cast<int>(link.number_of_stops)).Key("time"s).Value(time).EndDict();
-        builder.Value(std::move(bus_builder.Build()));
+        writer.StartDict().Key("bus"sv).Value(link.bus_name).Key("span_count"sv).Value(static_cast<int>(link.number_of_stops))
+                .Key("time"sv).Value(time).Key("type"sv).Value("Bus"sv).EndDict();
+    }
+    writer.EndArray().Key("request_id"sv).Value(id).Key("total_time"sv).Value(route->weight).EndDict();
+}
+
+void JsonReader::WriteNearestStopsResponse(int id, const json::Dict& request_fields, const CatalogueVersion& version,
+                                           json::Writer& writer) const {
+    const auto point = ParseCoordinates(request_fields);
+    const auto count_i = request_fields.find("count"s);
+    if (!point || count_i == request_fields.end() || !count_i->second.IsInt() || count_i->second.AsInt() < 0) {
+        throw json::ParsingError("Error reading JSON data with user requests to database. NearestStops fields are crippled.");
+    }
+
+    writer.StartDict().Key("request_id"sv).Value(id).Key("stops"sv).StartArray();
+    for (const auto& found : version.spatial_index->FindNearest(point.value(), count_i->second.AsInt())) {
+        writer.StartDict().Key("distance"sv).Value(found.distance).Key("name"sv).Value(found.stop->stop_name).EndDict();
+    }
+    writer.EndArray().EndDict();
+}
+
+void JsonReader::WriteStopsInRadiusResponse(int id, const json::Dict& request_fields, const CatalogueVersion& version,
+                                            json::Writer& writer) const {
+    const auto point = ParseCoordinates(request_fields);
+    const auto radius_i = request_fields.find("radius"s);
+    if (!point || radius_i == request_fields.end() || !radius_i->second.IsDouble()) {
+        throw json::ParsingError("Error reading JSON data with user requests to database. StopsInRadius fields are crippled.");
+    }
+
+    writer.StartDict().Key("request_id"sv).Value(id).Key("stops"sv).StartArray();
+    for (const auto& found : version.spatial_index->FindInRadius(point.value(), radius_i->second.AsDouble())) {
+        writer.StartDict().Key("distance"sv).Value(found.distance).Key("name"sv).Value(found.stop->stop_name).EndDict();
+    }
+    writer.EndArray().EndDict();
+}
+
+void JsonReader::WriteStopsInAreaResponse(int id, const json::Dict& request_fields, const CatalogueVersion& version,
+                                          json::Writer& writer) const {
+    geo::Coordinates min {}, max {};
+    const std::pair<const char*, double*> fields[] = {{"min_latitude", &min.lat}, {"min_longitude", &min.lng},
+                                                      {"max_latitude", &max.lat}, {"max_longitude", &max.lng}};
+    for (const auto& [field, value] : fields) {
+        if (const auto field_i = request_fields.find(field); field_i != request_fields.end() && field_i->second.IsDouble()) {
+            *value = field_i->second.AsDouble();
+        } else {
+            throw json::ParsingError("Error reading JSON data with user requests to database. StopsInArea fields are crippled.");
+        }
+    }
+
+    writer.StartDict().Key("request_id"sv).Value(id).Key("stops"sv).StartArray();
+    for (const transport_catalogue::Stop* stop : version.spatial_index->FindInArea(min, max)) {
+        writer.Value(stop->stop_name);
+    }
+    writer.EndArray().EndDict();
+}
+
+void JsonReader::WriteSuggestResponse(int id, const json::Dict& request_fields, const CatalogueVersion& version,
+                                      json::Writer& writer) const {
+    const auto prefix_i = request_fields.find("prefix"s);
+    const auto count_i = request_fields.find("count"s);
+    if (prefix_i == request_fields.end() || !prefix_i->second.IsString()
+        || count_i == request_fields.end() || !count_i->second.IsInt() || count_i->second.AsInt() < 0) {
+        throw json::ParsingError("Error reading JSON data with user requests to database. Suggest fields are crippled.");
+    }
+    // "kind" is "Stop" or "Bus", both kinds are suggested without it
+    std::string kind;
+    if (const auto kind_i = request_fields.find("kind"s); kind_i != request_fields.end()) {
+        if (!kind_i->second.IsString() || (kind_i->second.AsString() != "Stop"sv && kind_i->second.AsString() != "Bus"sv)) {
+            throw json::ParsingError("Error reading JSON data with user requests to database. Suggest->kind field is crippled.");
+        }
+        kind = kind_i->second.AsString();
     }
-    builder.EndArray().EndDict();
+    const std::string_view prefix = prefix_i->second.AsString();
+    const size_t count = count_i->second.AsInt();
+
+    writer.StartDict();
+    if (kind != "Stop"s) {
+        writer.Key("buses"sv).StartArray();
+        size_t added = 0;
+        for (const transport_catalogue::BusRoute* route : version.catalogue->FindRoutesByPrefix(prefix)) {
+            if (added++ == count) break;
+            writer.Value(route->bus_name);
+        }
+        writer.EndArray();
+    }
+    writer.Key("request_id"sv).Value(id);
+    if (kind != "Bus"s) {
+        writer.Key("stops"sv).StartArray();
+        size_t added = 0;
+        for (const transport_catalogue::Stop* stop : version.catalogue->FindStopsByPrefix(prefix)) {
+            if (added++ == count) break;
+            writer.Value(stop->stop_name);
+        }
+        writer.EndArray();
+    }
+    writer.EndDict();
+}
+
+namespace {
+
+// json has no unsigned or 64-bit integers, big sizes go out as doubles
+json::Node BytesNode(size_t bytes) {
+    if (bytes <= static_cast<size_t>(std::numeric_limits<int>::max())) {
+        return json::Node(static_cast<int>(bytes));
+    }
+    return json::Node(static_cast<double>(bytes));
+}
+
+json::Node MemoryUsageDict(const memory::MemoryUsage& usage) {
+    json::Builder builder;
+    builder.StartDict();
+    for (const auto& [name, bytes] : usage.GetStructures()) {
+        builder.Key(name).Value(BytesNode(bytes));
+    }
+    builder.Key("total"s).Value(BytesNode(usage.Total())).EndDict();
 
     return builder.Build();
 }
 
+} // namespace
+
+void JsonReader::WriteMemoryUsageResponse(int id, const CatalogueVersion& version, json::Writer& writer) const {
+    // a rare request, the node is built as before and sorted by the dictionary
+    json::Builder builder;
+    builder.StartDict().Key("request_id"s).Value(id);
+
+    size_t total = 0;
+    const auto add_section = [&builder, &total](const std::string& name, const memory::MemoryUsage& usage) {
+        builder.Key(name).Value(MemoryUsageDict(usage));
+        total += usage.Total();
+    };
+    add_section("catalogue"s, version.catalogue->MemoryUsage());
+    if (version.graph) {
+        add_section("graph"s, version.graph->MemoryUsage());
+        add_section("router"s, version.graph->RouterMemoryUsage());
+    }
+    if (version.spatial_index) {
+        add_section("spatial_index"s, version.spatial_index->MemoryUsage());
+    }
+    builder.Key("total_bytes"s).Value(BytesNode(total)).EndDict();
+
+    writer.Value(builder.Build());
+}
+
 std::optional<graph::Router<double>::RouteInfo> JsonReader::GenerateRoute(std::string_view from_stop, std::string_view to_stop) const {
-    return graph_ptr_->BuildRoute(from_stop, to_stop);
+    return CurrentVersion()->graph->BuildRoute(from_stop, to_stop);
+}
+
+void JsonReader::UseSnapshots(const CatalogueSnapshots& snapshots) {
+    snapshots_ = &snapshots;
+}
+
+std::shared_ptr<CatalogueVersion> JsonReader::MakeCatalogueVersion() const {
+    auto version = std::make_shared<CatalogueVersion>();
+    // non-owning pointer, the catalogue belongs to the caller of the reader
+    version->catalogue = std::shared_ptr<const transport_catalogue::TransportCatalogue>(std::shared_ptr<void>{}, &transport_catalogue_);
+    version->graph = graph_ptr_;
+    version->spatial_index = spatial_ptr_;
+
+    std::lock_guard lock(settings_mutex_);
+    version->routing_settings = routing_settings_.value_or(RoutingSettings{});
+    version->renderer_settings = renderer_settings_;
+
+    return version;
+}
+
+std::shared_ptr<const CatalogueVersion> JsonReader::CurrentVersion() const {
+    if (snapshots_ != nullptr) {
+        if (auto version = snapshots_->Acquire()) {
+            return version;
+        }
+        throw std::logic_error("Error answering user requests, no catalogue version is published.");
+    }
+
+    std::lock_guard lock(own_version_mutex_);
+    if (!own_version_) {
+        own_version_ = MakeCatalogueVersion();
+    }
+    return own_version_;
 }
 
 SerializationSettings JsonReader::GetSerializationSettings() const {
@@ -547,6 +919,12 @@ SerializationSettings JsonReader::GetSerializationSettings() const {
     } else {
         throw json::ParsingError("Error while parsing serialization settings, file name data is corrupt.");
     }
+    if (const auto delta = serialization_settings.find("delta"); delta != serialization_settings.end()) {
+        if (!delta->second.IsString()) {
+            throw json::ParsingError("Error while parsing serialization settings, delta file name data is corrupt.");
+        }
+        result.delta_file_name = delta->second.AsString();
+    }
 
     return std::move(result);
 }
@@ -556,13 +934,139 @@ void JsonReader::SaveTo(tc_serialize::TransportCatalogue &t_cat) const {
     *t_cat.mutable_render_settings() = std::move(SerializeRendererSettings(GetRendererSetting()));
     *(t_cat.mutable_router_settings()->mutable_routing_settings()) = std::move(SerializeRouting(GetRoutingSettings()));
     graph_ptr_->SaveTo(t_cat);
+    spatial_ptr_->SaveTo(t_cat);
+}
+
+size_t JsonReader::ApplyDelta(std::istream& input) {
+    using namespace transport_catalogue;
+
+    const json::Document doc = json::Load(input);
+    if (!doc.GetRoot().IsDict()) {
+        throw json::ParsingError("Error reading JSON delta, the root is not a dictionary.");
+    }
+    const auto iter = doc.GetRoot().AsDict().find(DELTA_REQUESTS);
+    if (iter == doc.GetRoot().AsDict().end() || !iter->second.IsArray()) {
+        throw json::ParsingError("Error reading JSON delta, no delta_requests array.");
+    }
+
+    // Stops go first, so that distances and buses of the delta can refer to new stops.
+    // A Stop entry without coordinates changes the distances of an existing stop only.
+    // Buses are then removed and replaced in the order of the file.
+    std::vector<StopWithDistances> stops;
+    std::vector<StopWithDistances> distances_only;
+    std::vector<std::variant<std::string, BusRouteJson>> bus_changes;
+    for (const json::Node& node : iter->second.AsArray()) {
+        const json::Node* type = nullptr;
+        if (node.IsDict()) {
+            if (const auto type_i = node.AsDict().find("type"s); type_i != node.AsDict().end()) {
+                type = &type_i->second;
+            }
+        }
+        if (type != nullptr && *type == json::Node{"RemoveBus"s}) {
+            const auto name_i = node.AsDict().find("name"s);
+            if (name_i == node.AsDict().end() || !name_i->second.IsString()) {
+                throw json::ParsingError("Error reading JSON delta, RemoveBus->name field is crippled.");
+            }
+            bus_changes.emplace_back(std::string(name_i->second.AsString()));
+            continue;
+        }
+        if (type != nullptr && *type == json::Node{"Stop"s}
+            && node.AsDict().count("latitude"s) == 0 && node.AsDict().count("longitude"s) == 0) {
+            BaseRequest data = ParseDataStop(node.AsDict(), false);
+            if (auto* stop = std::get_if<StopWithDistances>(&data)) {
+                distances_only.emplace_back(std::move(*stop));
+                continue;
+            }
+            throw json::ParsingError("Error reading JSON delta, unknown or crippled request.");
+        }
+        BaseRequest data = ParseDataNode(node);
+        if (auto* stop = std::get_if<StopWithDistances>(&data)) {
+            stops.emplace_back(std::move(*stop));
+        } else if (auto* bus = std::get_if<BusRouteJson>(&data)) {
+            bus_changes.emplace_back(std::move(*bus));
+        } else {
+            throw json::ParsingError("Error reading JSON delta, unknown or crippled request.");
+        }
+    }
+
+    // the graph does not use coordinates, moved stops change the spatial index only
+    bool stops_changed = false;
+    bool graph_changed = false;
+    size_t applied = 0;
+    // the name indexes are sorted once for the whole delta
+    transport_catalogue_.StartBatch();
+    for (const StopWithDistances& stop : stops) {
+        if (transport_catalogue_.FindStop(stop.stop_name).first) {
+            transport_catalogue_.UpdateStopCoordinates(stop.stop_name, stop.coordinates);
+        } else {
+            transport_catalogue_.AddStop(stop.stop_name, stop.coordinates);
+            graph_changed = true;
+        }
+        stops_changed = true;
+        ++applied;
+    }
+    // every distance counts as a change, an implied reverse distance follows it as a rebuild would do
+    for (const auto* entries : {&stops, &distances_only}) {
+        for (const StopWithDistances& stop : *entries) {
+            for (const auto& [other_name, distance] : stop.distances) {
+                if (!transport_catalogue_.UpdateDistance(stop.stop_name, other_name, static_cast<int>(distance))) {
+                    std::cerr << "Error in delta, unknown stop for the distance "s << stop.stop_name << " - " << other_name << std::endl;
+                    continue;
+                }
+                graph_changed = true;
+                ++applied;
+            }
+        }
+    }
+    for (const auto& change : bus_changes) {
+        if (const auto* name = std::get_if<std::string>(&change)) {
+            if (!transport_catalogue_.RemoveBus(*name)) {
+                std::cerr << "Error in delta, no bus to remove: "s << *name << std::endl;
+                continue;
+            }
+            graph_changed = true;
+            ++applied;
+            continue;
+        }
+        const BusRouteJson& bus_json = std::get<BusRouteJson>(change);
+        BusRoute bus {bus_json.bus_name, bus_json.type, {}};
+        for (const std::string& stop_name : bus_json.route_stops) {
+            const auto [found, stop] = transport_catalogue_.FindStop(stop_name);
+            if (!found) break;
+            bus.route_stops.push_back(&stop);
+        }
+        if (bus.route_stops.size() < 2 || bus.route_stops.size() != bus_json.route_stops.size()) {
+            std::cerr << "Error in delta, the bus "s << bus.bus_name << " has unknown stops or less than 2 stops." << std::endl;
+            continue;
+        }
+        transport_catalogue_.ReplaceBus(bus);
+        graph_changed = true;
+        ++applied;
+    }
+    transport_catalogue_.FinishBatch();
+
+    // Neither is patched: the grid bounds follow the stops, and the router precomputes all pairs
+    // of vertices, so any change of an edge makes all of it stale.
+    if (graph_changed) {
+        graph_ptr_ = std::make_shared<TransportCatalogueRouterGraph>(transport_catalogue_, GetRoutingSettings());
+    }
+    if (stops_changed) {
+        spatial_ptr_ = std::make_shared<StopsSpatialIndex>(transport_catalogue_);
+    }
+    if (graph_changed || stops_changed) {
+        own_version_.reset();
+    }
+
+    return applied;
 }
 
 bool JsonReader::RestoreFrom(tc_serialize::TransportCatalogue &t_cat) {
     renderer_settings_.emplace(DeserializeRenderSetting(t_cat.render_settings()));
     routing_settings_.emplace(DeserializeRouting(t_cat.router_settings().routing_settings()));
 
-    graph_ptr_ = std::make_unique<TransportCatalogueRouterGraph>(transport_catalogue_, routing_settings_.value(), t_cat);
+    graph_ptr_ = std::make_shared<TransportCatalogueRouterGraph>(transport_catalogue_, routing_settings_.value(), t_cat);
+    spatial_ptr_ = RestoreSpatialIndex(transport_catalogue_, t_cat);
+    own_version_.reset();
 
     return true;
 }
@@ -570,7 +1074,7 @@ bool JsonReader::RestoreFrom(tc_serialize::TransportCatalogue &t_cat) {
 
 svg::Color ParseColor(const json::Node& node){
     if (node.IsString()) {
-        return {node.AsString()};
+        return {std::string(node.AsString())};
     }
 
     if (node.IsArray()) {
@@ -596,8 +1100,6 @@ svg::Color ParseColor(const json::Node& node){
 }
 
 
-inline json::Node GetErrorNode(int id) {
-    return json::Builder().StartDict().Key("request_id"s).Value(id)
-                .Key("error_message"s).Value("not found"s).EndDict()
-                .Build();
+void WriteErrorResponse(int id, json::Writer& writer) {
+    writer.StartDict().Key("error_message"sv).Value("not found"sv).Key("request_id"sv).Value(id).EndDict();
 }
@@ -2,6 +2,7 @@
 
 #include <sstream>
 #include "json.h"
+#include "json_writer.h"
 #include "transport_catalogue.h"
 #include "transport_catalogue.pb.h"
 #include "map_renderer.h"
@@ -9,7 +10,10 @@
 #include "router.h"
 #include "transport_router.h"
 #include <vector>
+#include <mutex>
 #include "serialization.h"
+#include "catalogue_snapshot.h"
+#include "repeated_requests.h"
 
 
 const std::string BASE_DATA = "base_requests";
@@ -17,18 +21,23 @@ const std::string USER_REQUESTS = "stat_requests";
 const std::string RENDER_SETTINGS = "render_settings";
 const std::string ROUTING_SETTINGS = "routing_settings";
 const std::string SERIALIZE_SETTINGS = "serialization_settings";
+const std::string DELTA_REQUESTS = "delta_requests";
 
 
-struct BusRouteJson {
-    std::string bus_name;
-    transport_catalogue::RouteType type;
-    std::vector<std::string> route_stops;
-};
+using BusRouteJson = transport_catalogue::BusWithStopNames;
 
 
 using BaseRequest = std::variant<std::monostate, transport_catalogue::StopWithDistances, BusRouteJson>;
 
 
+// Counters of answered stat requests
+struct RequestCounters {
+    size_t requests = 0;
+    // of them answered with the response to an earlier request of the same batch
+    size_t reused = 0;
+};
+
+
 class JsonReader {
 public:
     explicit JsonReader(transport_catalogue::TransportCatalogue& tc) : transport_catalogue_(tc) {
@@ -37,17 +46,41 @@ public:
     size_t ReadJson(std::istream& input);
 
     size_t ReadJsonToTransportCatalogue(std::istream& input);
-    size_t QueryTcWriteJsonToStream(std::ostream& out);
+    // With threads > 1 the requests are answered by that many threads, the output is the same
+    // and in the same order as with one thread
+    size_t QueryTcWriteJsonToStream(std::ostream& out, size_t threads = 1);
+    RequestCounters GetRequestCounters() const;
+    // Answers "stat_requests" of a separate document, which is not kept: the settings stay
+    // those of the data loaded before
+    size_t AnswerBatch(const json::Node& batch, std::ostream& out, size_t threads = 1);
 
     size_t ReadJsonQueryTcWriteJsonToStream(std::istream & input, std::ostream& out);
+    // JSON Lines: every input line is one stat request, its response goes out as one line
+    // as soon as it is ready. A bad line is reported to std::cerr and gets {"error_message": ...}
+    // with its "request_id" when the line has one. Returns the number of answered requests.
+    size_t AnswerRequestLines(std::istream& input, std::ostream& out);
     std::optional<graph::Router<double>::RouteInfo> GenerateRoute(std::string_view from_stop, std::string_view to_stop) const;
 
+    // Answer user requests from the versions published in snapshots instead of the own catalogue.
+    // Every batch of requests is answered from one version, taken when the batch starts.
+    void UseSnapshots(const CatalogueSnapshots& snapshots);
+    // Makes a version out of the data loaded by this reader, the catalogue itself is not copied
+    std::shared_ptr<CatalogueVersion> MakeCatalogueVersion() const;
+
     [[nodiscard]] RendererSettings GetRendererSetting() const;
     RoutingSettings GetRoutingSettings() const;
     SerializationSettings GetSerializationSettings() const;
 
     void SaveTo(tc_serialize::TransportCatalogue& t_cat) const;
     bool RestoreFrom(tc_serialize::TransportCatalogue& t_cat);
+    // Applies changes on top of the restored base: "delta_requests" holds Stop and Bus entries in
+    // the base_requests format, which add or replace, and {"type": "RemoveBus", "name": ...}.
+    // A Stop entry without coordinates changes only the road_distances of an existing stop.
+    // Returns the number of applied changes, every distance counted. The catalogue changes in place, the graph and the
+    // spatial index do not: new stops, distances and buses build the graph and the router anew,
+    // O(stops^3) for the all-pairs router, which is most of the cost of a delta; new or moved
+    // stops build the spatial index anew, O(stops).
+    size_t ApplyDelta(std::istream& input);
 
 private:
     transport_catalogue::TransportCatalogue& transport_catalogue_;
@@ -56,20 +89,37 @@ private:
     std::vector<BusRouteJson> raw_buses_;
     mutable std::optional<RoutingSettings> routing_settings_;
     mutable std::optional<RendererSettings> renderer_settings_;
-    std::unique_ptr<TransportCatalogueRouterGraph> graph_ptr_;
+    // the settings above are filled on the first use, which may happen in several threads at once
+    mutable std::mutex settings_mutex_;
+    std::shared_ptr<TransportCatalogueRouterGraph> graph_ptr_;
+    std::shared_ptr<transport_catalogue::StopsSpatialIndex> spatial_ptr_;
+    const CatalogueSnapshots* snapshots_ = nullptr;
+    // the version of the own data is made on the first request and kept until the data changes
+    mutable std::shared_ptr<const CatalogueVersion> own_version_;
+    mutable std::mutex own_version_mutex_;
+    RequestCounters request_counters_;
 
     BaseRequest ParseDataNode(const json::Node& node) const;
-    size_t ParseJsonToRawData();
     bool FillTransportCatalogue();
-    json::Node ProcessOneUserRequestNode(const json::Node& user_request);
+    std::shared_ptr<const CatalogueVersion> CurrentVersion() const;
+    size_t WriteResponses(const json::Node& root_node, std::ostream& out, size_t threads);
+    void ProcessOneUserRequest(const json::Node& user_request, const CatalogueVersion& version, json::Writer& writer);
+    void AnswerInParallel(const json::Array& requests, const CatalogueVersion& version, size_t threads,
+                          RepeatedRequests& repeated, json::Writer& writer);
     std::optional<geo::Coordinates> ParseCoordinates(const json::Dict& dict) const;
-    BaseRequest ParseDataStop(const json::Dict& dict) const;
+    BaseRequest ParseDataStop(const json::Dict& dict, bool with_coordinates = true) const;
     BaseRequest ParseDataBus(const json::Dict& dict) const;
-    json::Node GenerateMapNode(int id) const;
-    json::Node GenerateBusNode(int id, std::string& name) const;
-    json::Node GenerateStopNode(int id, std::string& name) const;
-    json::Node GenerateRouteNode(int id, std::string_view from, std::string_view to) const;
+    const std::string& GetMapJson(const CatalogueVersion& version) const;
+    void WriteMapResponse(int id, const CatalogueVersion& version, json::Writer& writer) const;
+    void WriteBusResponse(int id, std::string& name, const CatalogueVersion& version, json::Writer& writer) const;
+    void WriteStopResponse(int id, std::string& name, const CatalogueVersion& version, json::Writer& writer) const;
+    void WriteRouteResponse(int id, std::string_view from, std::string_view to, const CatalogueVersion& version, json::Writer& writer) const;
+    void WriteNearestStopsResponse(int id, const json::Dict& request_fields, const CatalogueVersion& version, json::Writer& writer) const;
+    void WriteStopsInRadiusResponse(int id, const json::Dict& request_fields, const CatalogueVersion& version, json::Writer& writer) const;
+    void WriteStopsInAreaResponse(int id, const json::Dict& request_fields, const CatalogueVersion& version, json::Writer& writer) const;
+    void WriteSuggestResponse(int id, const json::Dict& request_fields, const CatalogueVersion& version, json::Writer& writer) const;
+    void WriteMemoryUsageResponse(int id, const CatalogueVersion& version, json::Writer& writer) const;
 };
 
 svg::Color ParseColor(const json::Node& node);
-inline json::Node GetErrorNode(int id);
+void WriteErrorResponse(int id, json::Writer& writer);
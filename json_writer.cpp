@@ -0,0 +1,242 @@
+#include "json_writer.h"
+
+using namespace std::literals;
+
+namespace json {
+
+    Writer::Writer(std::ostream& out, size_t flush_size, Layout layout)
+            : out_(&out)
+            , flush_size_(flush_size)
+            , layout_(layout) {
+        buffer_.reserve(flush_size_);
+    }
+
+    Writer::Writer(size_t depth, Layout layout)
+            : out_(nullptr)
+            , flush_size_(0)
+            , layout_(layout)
+            , base_depth_(depth) {
+    }
+
+    void Writer::NewLine(size_t depth) {
+        if (layout_ == Layout::COMPACT) return;
+
+        buffer_ += '\n';
+        buffer_.append((base_depth_ + depth) * 4, ' ');
+    }
+
+    void Writer::BeforeValue() {
+        if (after_key_) {
+            after_key_ = false;
+            return;
+        }
+        if (empty_.empty()) return;
+
+        if (!empty_.back()) {
+            buffer_ += ',';
+        }
+        empty_.back() = false;
+        NewLine(empty_.size());
+    }
+
+    void Writer::MaybeFlush() {
+        if (out_ != nullptr && empty_.size() <= 1 && buffer_.size() >= flush_size_) {
+            Flush();
+        }
+    }
+
+    void Writer::Flush() {
+        if (out_ == nullptr) return;
+
+        out_->write(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+        buffer_.clear();
+    }
+
+    std::string_view Writer::GetText() const {
+        return buffer_;
+    }
+
+    void Writer::Clear() {
+        buffer_.clear();
+        empty_.clear();
+        after_key_ = false;
+    }
+
+    Writer& Writer::StartDict() {
+        BeforeValue();
+        buffer_ += '{';
+        empty_.push_back(true);
+        return *this;
+    }
+
+    Writer& Writer::Key(std::string_view key) {
+        BeforeValue();
+        // keys go as they are, the same as in json::Print
+        buffer_ += '"';
+        buffer_ += key;
+        buffer_ += layout_ == Layout::COMPACT ? "\":"sv : "\": "sv;
+        after_key_ = true;
+        return *this;
+    }
+
+    void Writer::EndContainer(char bracket) {
+        empty_.pop_back();
+        NewLine(empty_.size());
+        buffer_ += bracket;
+        MaybeFlush();
+    }
+
+    Writer& Writer::EndDict() {
+        EndContainer('}');
+        return *this;
+    }
+
+    Writer& Writer::StartArray() {
+        BeforeValue();
+        buffer_ += '[';
+        empty_.push_back(true);
+        return *this;
+    }
+
+    Writer& Writer::EndArray() {
+        EndContainer(']');
+        return *this;
+    }
+
+    Writer& Writer::Value(std::nullptr_t) {
+        BeforeValue();
+        buffer_ += "null"sv;
+        MaybeFlush();
+        return *this;
+    }
+
+    Writer& Writer::Value(bool value) {
+        BeforeValue();
+        buffer_ += value ? "true"sv : "false"sv;
+        MaybeFlush();
+        return *this;
+    }
+
+    Writer& Writer::Value(int value) {
+        BeforeValue();
+        char number[MAX_NUMBER_CHARS];
+        buffer_.append(number, FormatNumber(value, number));
+        MaybeFlush();
+        return *this;
+    }
+
+    Writer& Writer::Value(double value) {
+        BeforeValue();
+        char number[MAX_NUMBER_CHARS];
+        buffer_.append(number, FormatNumber(value, number));
+        MaybeFlush();
+        return *this;
+    }
+
+    void Writer::WriteString(std::string_view value) {
+        buffer_ += '"';
+        AppendEscaped(buffer_, value);
+        buffer_ += '"';
+    }
+
+    Writer& Writer::Value(std::string_view value) {
+        BeforeValue();
+        WriteString(value);
+        MaybeFlush();
+        return *this;
+    }
+
+    Writer& Writer::Value(const char* value) {
+        return Value(std::string_view(value));
+    }
+
+    Writer& Writer::Value(const std::string& value) {
+        return Value(std::string_view(value));
+    }
+
+    Writer& Writer::Raw(std::string_view text) {
+        BeforeValue();
+        buffer_ += text;
+        MaybeFlush();
+        return *this;
+    }
+
+    Writer& Writer::Value(const Node& node) {
+        if (node.IsArray()) {
+            StartArray();
+            for (const Node& item : node.AsArray()) {
+                Value(item);
+            }
+            return EndArray();
+        }
+        if (node.IsDict()) {
+            StartDict();
+            for (const auto& [key, value] : node.AsDict()) {
+                Key(key).Value(value);
+            }
+            return EndDict();
+        }
+        std::visit([this](const auto& value) {
+            using T = std::decay_t<decltype(value)>;
+            if constexpr (std::is_same_v<T, String>) {
+                Value(std::string_view(value));
+            } else if constexpr (!std::is_same_v<T, Array> && !std::is_same_v<T, Dict>) {
+                Value(value);
+            }
+        }, node.GetValue());
+        return *this;
+    }
+
+    void AppendEscaped(std::string& out, std::string_view text) {
+        // the same escapes as PrintValue(const String&)
+        while (!text.empty()) {
+            const size_t special = text.find_first_of("\"\r\n\\"sv);
+            out += text.substr(0, special);
+            if (special == std::string_view::npos) break;
+
+            switch (text[special]) {
+                case '"':
+                    out += "\\\""sv;
+                    break;
+                case '\r':
+                    out += "\\r"sv;
+                    break;
+                case '\n':
+                    out += "\\n"sv;
+                    break;
+                default:
+                    out += "\\\\"sv;
+            }
+            text.remove_prefix(special + 1);
+        }
+    }
+
+    EscapingStreamBuf::EscapingStreamBuf(std::string& out)
+            : out_(out) {
+        setp(chunk_, chunk_ + sizeof(chunk_));
+    }
+
+    EscapingStreamBuf::~EscapingStreamBuf() {
+        Drain();
+    }
+
+    void EscapingStreamBuf::Drain() {
+        AppendEscaped(out_, std::string_view(pbase(), pptr() - pbase()));
+        setp(chunk_, chunk_ + sizeof(chunk_));
+    }
+
+    EscapingStreamBuf::int_type EscapingStreamBuf::overflow(int_type ch) {
+        Drain();
+        if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+            *pptr() = traits_type::to_char_type(ch);
+            pbump(1);
+        }
+        return traits_type::not_eof(ch);
+    }
+
+    int EscapingStreamBuf::sync() {
+        Drain();
+        return 0;
+    }
+
+}  // namespace json
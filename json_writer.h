@@ -0,0 +1,97 @@
+#pragma once
+
+#include "json.h"
+
+#include <iostream>
+#include <streambuf>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace json {
+
+    // Writes JSON as it goes, in the same layout as json::Print, without building nodes.
+    // Text is gathered in a buffer and goes to the stream in big pieces: whenever the buffer
+    // grows over flush_size after a top-level item, and on Flush().
+    // Keys are written in the order they are given; json::Print sorts them, so callers that
+    // want the same text give keys in sorted order.
+    // The compact layout has no line breaks and spaces, so every top-level value fits in one line.
+    class Writer {
+    public:
+        enum class Layout {
+            PRETTY,
+            COMPACT
+        };
+
+        explicit Writer(std::ostream& out, size_t flush_size = 1 << 16, Layout layout = Layout::PRETTY);
+        // Keeps the text in the buffer only, to be put into another writer with Raw().
+        // depth is where the value will go there, so that the indents match.
+        explicit Writer(size_t depth, Layout layout = Layout::PRETTY);
+        Writer(const Writer&) = delete;
+        Writer& operator=(const Writer&) = delete;
+
+        Writer& StartDict();
+        Writer& Key(std::string_view key);
+        Writer& EndDict();
+        Writer& StartArray();
+        Writer& EndArray();
+
+        Writer& Value(std::nullptr_t);
+        Writer& Value(bool value);
+        Writer& Value(int value);
+        Writer& Value(double value);
+        Writer& Value(std::string_view value);
+        Writer& Value(const char* value);
+        Writer& Value(const std::string& value);
+        Writer& Value(const Node& node);
+        // a value already written by a buffer-only writer
+        Writer& Raw(std::string_view text);
+
+        // the rest of the buffer goes to the stream
+        void Flush();
+
+        // for a buffer-only writer
+        std::string_view GetText() const;
+        void Clear();
+
+    private:
+        std::ostream* out_;
+        std::string buffer_;
+        size_t flush_size_;
+        Layout layout_;
+        size_t base_depth_ = 0;
+        // by open container: if nothing is written in it yet
+        std::vector<bool> empty_;
+        bool after_key_ = false;
+
+        void BeforeValue();
+        void NewLine(size_t depth);
+        void EndContainer(char bracket);
+        void WriteString(std::string_view value);
+        void MaybeFlush();
+    };
+
+    // Appends text as the contents of a JSON string, with the same escapes as json::Print
+    void AppendEscaped(std::string& out, std::string_view text);
+
+    // Everything written through it goes to out escaped, as the contents of a JSON string.
+    // Lets a big text be rendered right into its JSON form, to be put into a Writer with Raw().
+    class EscapingStreamBuf : public std::streambuf {
+    public:
+        explicit EscapingStreamBuf(std::string& out);
+        EscapingStreamBuf(const EscapingStreamBuf&) = delete;
+        EscapingStreamBuf& operator=(const EscapingStreamBuf&) = delete;
+        ~EscapingStreamBuf() override;
+
+    protected:
+        int_type overflow(int_type ch) override;
+        int sync() override;
+
+    private:
+        std::string& out_;
+        char chunk_[4096];
+
+        void Drain();
+    };
+
+}  // namespace json
@@ -1,15 +1,52 @@
 #include <iostream>
 #include <fstream>
+#include <sstream>
+#include <charconv>
 #include "transport_catalogue.h"
 #include "json_reader.h"
 #include "map_renderer.h"
+#include "request_server.h"
 
 using namespace transport_catalogue;
 using namespace std::literals;
 
 
 void PrintUsage(std::ostream& stream = std::cerr) {
-    stream << "Usage: transport_catalogue [make_base|process_requests]\n"sv;
+    stream << "Usage: transport_catalogue [make_base|process_requests [--jsonl]|serve] [--threads N] [--stats]\n"sv;
+}
+
+// Reads the settings, restores the base they name and applies the delta if there is one
+bool LoadBase(std::istream& settings_input, TransportCatalogue& tc, JsonReader& reader) {
+    reader.ReadJson(settings_input);
+    tc_serialize::TransportCatalogue t_cat;
+
+    SerializationSettings settings = reader.GetSerializationSettings();
+    std::ifstream input_file(settings.file_name, std::ios::binary | std::ios::in);
+
+    t_cat.ParseFromIstream(&input_file);
+
+    tc.RestoreFrom(t_cat);
+    reader.RestoreFrom(t_cat);
+
+    if (!settings.delta_file_name.empty()) {
+        std::ifstream delta_file(settings.delta_file_name);
+        if (!delta_file) {
+            std::cerr << "Cannot open the delta file "sv << settings.delta_file_name << std::endl;
+            return false;
+        }
+        reader.ApplyDelta(delta_file);
+    }
+
+    return true;
+}
+
+void PrintRequestCounters(const JsonReader& reader) {
+    const RequestCounters counters = reader.GetRequestCounters();
+    std::cerr << "Requests: "sv << counters.requests << ", answered with an earlier response: "sv << counters.reused;
+    if (counters.requests > 0) {
+        std::cerr << " ("sv << 100.0 * static_cast<double>(counters.reused) / static_cast<double>(counters.requests) << "%)"sv;
+    }
+    std::cerr << std::endl;
 }
 
 
@@ -20,12 +57,38 @@ int main(int argc, char* argv[]) {
 //    reader.QueryTcWriteJsonToStream(std::cout);
 //    return 0;
 
-    if (argc != 2) {
+    if (argc < 2) {
         PrintUsage();
         return 1;
     }
 
     const std::string_view mode(argv[1]);
+    // with --jsonl the first line of the input holds the settings, every next line is one stat request
+    bool json_lines = false;
+    // stat_requests of a batch are answered by that many threads
+    size_t threads = 1;
+    // counters of the answered requests go to std::cerr
+    bool print_stats = false;
+    for (int i = 2; i < argc; ++i) {
+        const std::string_view option(argv[i]);
+        bool valid = mode == "process_requests"sv || mode == "serve"sv;
+        if (option == "--jsonl"sv) {
+            json_lines = true;
+            valid = mode == "process_requests"sv;
+        } else if (option == "--stats"sv) {
+            print_stats = true;
+        } else if (option == "--threads"sv && i + 1 < argc) {
+            const std::string_view number(argv[++i]);
+            const auto [end, error] = std::from_chars(number.data(), number.data() + number.size(), threads);
+            valid = valid && error == std::errc{} && end == number.data() + number.size() && threads > 0;
+        } else {
+            valid = false;
+        }
+        if (!valid) {
+            PrintUsage();
+            return 1;
+        }
+    }
 
     if (mode == "make_base"sv) {
         reader.ReadJsonToTransportCatalogue(std::cin);
@@ -39,18 +102,51 @@ int main(int argc, char* argv[]) {
 
         t_cat.SerializeToOstream(&output_file);
     } else if (mode == "process_requests"sv) {
-        reader.ReadJson(std::cin);
-        tc_serialize::TransportCatalogue t_cat;
+        if (json_lines) {
+            std::string settings_line;
+            std::getline(std::cin, settings_line);
+            std::istringstream settings_input(settings_line);
+            if (!LoadBase(settings_input, tc, reader)) return 1;
+        } else if (!LoadBase(std::cin, tc, reader)) {
+            return 1;
+        }
 
-        SerializationSettings settings = reader.GetSerializationSettings();
-        std::ifstream input_file(settings.file_name, std::ios::binary | std::ios::in);
+        if (json_lines) {
+            reader.AnswerRequestLines(std::cin, std::cout);
+        } else {
+            reader.QueryTcWriteJsonToStream(std::cout, threads);
+        }
+        if (print_stats) {
+            PrintRequestCounters(reader);
+        }
+    } else if (mode == "serve"sv) {
+        // the first frame holds the settings, every next one a batch of stat requests
+        std::string settings_frame;
+        if (!ReadFrame(std::cin, settings_frame)) return 1;
 
-        t_cat.ParseFromIstream(&input_file);
+        // the first version owns its catalogue, so it can be freed once a reloaded base replaces it
+        CatalogueSnapshots snapshots;
+        std::string base_file;
+        std::string delta_file;
+        {
+            auto catalogue = std::make_shared<TransportCatalogue>();
+            JsonReader loader(*catalogue);
+            std::istringstream settings_input(settings_frame);
+            if (!LoadBase(settings_input, *catalogue, loader)) return 1;
 
-        tc.RestoreFrom(t_cat);
-        reader.RestoreFrom(t_cat);
+            base_file = loader.GetSerializationSettings().file_name;
+            delta_file = loader.GetSerializationSettings().delta_file_name;
+            auto version = loader.MakeCatalogueVersion();
+            version->catalogue = std::move(catalogue);
+            snapshots.Publish(std::move(version));
+        }
+        reader.UseSnapshots(snapshots);
 
-        reader.QueryTcWriteJsonToStream(std::cout);
+        RequestServer server(reader, snapshots, std::move(base_file), std::move(delta_file), threads);
+        server.Serve(std::cin, std::cout);
+        if (print_stats) {
+            PrintRequestCounters(reader);
+        }
     } else {
         PrintUsage();
         return 1;
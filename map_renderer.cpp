@@ -11,20 +11,20 @@ svg::Point SphereProjector::operator()(geo::Coordinates coords) const {
 
 void MapRenderer::RenderSvgMap(const transport_catalogue::TransportCatalogue &tc, svg::Document& svg_doc) {
     // get all routes and all stops of the routes
-    const std::map<std::string_view, const transport_catalogue::Stop*> stops = tc.GetAllStopsIndex();
+    const auto stops = tc.GetAllStopsIndex();
     stops_ = &stops;
 
     // prepare data for SphereProjector init
     std::vector<geo::Coordinates> all_route_stops_coordinates;
-    for (const auto& stop : stops) {
-        if ( tc.GetBusesForStop(stop.first).empty() ) continue;
-        all_route_stops_coordinates.push_back(stop.second->coordinates);
+    for (const auto stop : stops) {
+        if ( tc.GetBusesForStop(stop->id).empty() ) continue;
+        all_route_stops_coordinates.push_back(stop->coordinates);
     }
     SphereProjector projector(all_route_stops_coordinates.begin(), all_route_stops_coordinates.end(),
                               settings_.width, settings_.height, settings_.padding);
     projector_ = &projector;
 
-    const std::map<std::string_view, const transport_catalogue::BusRoute*> routes = tc.GetAllRoutesIndex();
+    const auto routes = tc.GetAllRoutesIndex();
     routes_ = &routes;
 
     RenderLines(svg_doc);
@@ -64,7 +64,7 @@ void MapRenderer::RenderLines(svg::Document &svg_doc) const {
     size_t color_count = 0;
     auto projector = *projector_;
     for (const auto route : *routes_) {
-        if (route.second->route_stops.empty()) continue;
+        if (route->route_stops.empty()) continue;
         svg::Color palette_color = GetNextPalleteColor(color_count);
 
         svg::Polyline line;
@@ -72,11 +72,11 @@ void MapRenderer::RenderLines(svg::Document &svg_doc) const {
                 .SetStrokeLineCap(svg::StrokeLineCap::ROUND).SetStrokeLineJoin(svg::StrokeLineJoin::ROUND);
 
 
-        for (auto iter = route.second->route_stops.begin(); iter != route.second->route_stops.end(); ++iter) {
+        for (auto iter = route->route_stops.begin(); iter != route->route_stops.end(); ++iter) {
             line.AddPoint(projector( (*iter)->coordinates ));
         }
-        if (route.second->type == transport_catalogue::RouteType::RETURN_ROUTE) {
-            for (auto back_iter = std::next(route.second->route_stops.rbegin()); back_iter != route.second->route_stops.rend(); ++back_iter) {
+        if (route->type == transport_catalogue::RouteType::RETURN_ROUTE) {
+            for (auto back_iter = std::next(route->route_stops.rbegin()); back_iter != route->route_stops.rend(); ++back_iter) {
                 line.AddPoint(projector( (*back_iter)->coordinates ));
             }
         }
@@ -89,12 +89,12 @@ void MapRenderer::RenderRouteNames(svg::Document& svg_doc) const {
     auto projector = *projector_;
     size_t color_count = 0;
 
-    for (auto route : *routes_) {
-        if (route.second->route_stops.empty()) continue;
+    for (const auto route : *routes_) {
+        if (route->route_stops.empty()) continue;
 
         svg::Text name_start_text;
 
-        name_start_text.SetData(std::string{route.first}).SetPosition( projector(route.second->route_stops.front()->coordinates) )
+        name_start_text.SetData(route->bus_name).SetPosition( projector(route->route_stops.front()->coordinates) )
         .SetOffset(settings_.bus_label_offset).SetFontSize(settings_.bus_label_font_size)
         .SetFontFamily("Verdana"s).SetFontWeight("bold"s).SetFillColor(GetNextPalleteColor(color_count));
 
@@ -106,11 +106,11 @@ void MapRenderer::RenderRouteNames(svg::Document& svg_doc) const {
         svg_doc.Add(name_start_plate);
         svg_doc.Add(name_start_text);
 
-        if (route.second->type == transport_catalogue::RouteType::CIRCLE_ROUTE) continue;
-        if (route.second->route_stops.front()->stop_name == route.second->route_stops.back()->stop_name) continue;
+        if (route->type == transport_catalogue::RouteType::CIRCLE_ROUTE) continue;
+        if (route->route_stops.front()->stop_name == route->route_stops.back()->stop_name) continue;
 
-        name_start_text.SetPosition(projector(route.second->route_stops.back()->coordinates));
-        name_start_plate.SetPosition(projector(route.second->route_stops.back()->coordinates));
+        name_start_text.SetPosition(projector(route->route_stops.back()->coordinates));
+        name_start_plate.SetPosition(projector(route->route_stops.back()->coordinates));
         svg_doc.Add(name_start_plate);
         svg_doc.Add(name_start_text);
     }
@@ -120,10 +120,10 @@ void MapRenderer::RenderStopCircles(const transport_catalogue::TransportCatalogu
     using namespace std::literals;
     auto projector = *projector_;
 
-    for (const auto& stop : *stops_) {
-        if ( tc.GetBusesForStop(stop.first).empty() ) continue;
+    for (const auto stop : *stops_) {
+        if ( tc.GetBusesForStop(stop->id).empty() ) continue;
         svg::Circle stop_circle;
-        stop_circle.SetCenter( projector(stop.second->coordinates) ).SetRadius(settings_.stop_radius).SetFillColor("white"s);
+        stop_circle.SetCenter( projector(stop->coordinates) ).SetRadius(settings_.stop_radius).SetFillColor("white"s);
         svg_doc.Add(stop_circle);
     }
 }
@@ -132,12 +132,12 @@ void MapRenderer::RenderStopNames(const transport_catalogue::TransportCatalogue&
     using namespace std::literals;
     auto projector = *projector_;
 
-    for (const auto& stop : *stops_) {
-        if ( tc.GetBusesForStop(stop.first).empty() ) continue;
+    for (const auto stop : *stops_) {
+        if ( tc.GetBusesForStop(stop->id).empty() ) continue;
 
         svg::Text stop_name;
-        stop_name.SetPosition(projector(stop.second->coordinates)).SetOffset(settings_.stop_label_offset)
-        .SetFontSize(settings_.stop_label_font_size).SetFontFamily("Verdana"s).SetData(std::string{stop.first});
+        stop_name.SetPosition(projector(stop->coordinates)).SetOffset(settings_.stop_label_offset)
+        .SetFontSize(settings_.stop_label_font_size).SetFontFamily("Verdana"s).SetData(stop->stop_name);
 
         svg::Text stop_plate = stop_name;
         stop_plate.SetFillColor(settings_.underlayer_color).SetStrokeColor(settings_.underlayer_color).SetStrokeWidth(settings_.underlayer_width)
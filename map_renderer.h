@@ -112,8 +112,8 @@ public:
 private:
     const RendererSettings& settings_;
     SphereProjector* projector_ = nullptr;
-    const std::map<std::string_view, const transport_catalogue::BusRoute*>* routes_ = nullptr;
-    const std::map<std::string_view, const transport_catalogue::Stop*>* stops_ = nullptr;
+    const transport_catalogue::TransportCatalogue::RoutesRange* routes_ = nullptr;
+    const transport_catalogue::TransportCatalogue::StopsRange* stops_ = nullptr;
 
     svg::Color GetNextPalleteColor(size_t &color_count) const;
     svg::Color GetPalletColor(size_t route_number) const;
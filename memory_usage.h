@@ -0,0 +1,60 @@
+#pragma once
+
+#include <deque>
+#include <numeric>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace memory {
+
+    // Bytes taken by every structure of an object, in the order they were added.
+    // Only the container payload is counted, sizeof of the object itself is not.
+    class MemoryUsage {
+    public:
+        using Structure = std::pair<std::string, size_t>;
+
+        void Add(std::string name, size_t bytes) {
+            structures_.emplace_back(std::move(name), bytes);
+        }
+
+        const std::vector<Structure>& GetStructures() const {
+            return structures_;
+        }
+
+        size_t Total() const {
+            return std::accumulate(structures_.begin(), structures_.end(), size_t {0},
+                                   [](size_t sum, const Structure& s) { return sum + s.second; });
+        }
+
+    private:
+        std::vector<Structure> structures_;
+    };
+
+    // The heap part of a string, zero while it fits the small string buffer
+    inline size_t BytesOf(const std::string& str) {
+        return str.capacity() > std::string().capacity() ? str.capacity() + 1 : 0;
+    }
+
+    template <typename T>
+    size_t BytesOf(const std::vector<T>& vec) {
+        return vec.capacity() * sizeof(T);
+    }
+
+    // libstdc++ layout: 512 byte blocks (or one element per block for larger ones) plus the block map
+    template <typename T>
+    size_t BytesOf(const std::deque<T>& deq) {
+        const size_t per_block = sizeof(T) < 512 ? 512 / sizeof(T) : 1;
+        const size_t blocks = deq.size() / per_block + 1;
+        return blocks * per_block * sizeof(T) + (blocks + 2) * sizeof(T*);
+    }
+
+    // One node per element (next pointer, value, cached hash) plus the bucket array
+    template <typename Key, typename Value, typename Hash, typename Equal>
+    size_t BytesOf(const std::unordered_map<Key, Value, Hash, Equal>& map) {
+        using Node = typename std::unordered_map<Key, Value, Hash, Equal>::value_type;
+        return map.size() * (sizeof(void*) + sizeof(Node) + sizeof(size_t)) + map.bucket_count() * sizeof(void*);
+    }
+
+} // namespace memory
@@ -0,0 +1,137 @@
+#include "name_index.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace transport_catalogue {
+
+namespace {
+
+const size_t NAMES_PER_BUCKET = 4;
+const uint32_t NO_NUMBER = std::numeric_limits<uint32_t>::max();
+
+uint64_t Mix(uint64_t x) {
+    // splitmix64 finalizer
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+}
+
+} // namespace
+
+uint64_t NameIndex::Hash(std::string_view name) {
+    // FNV-1a
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (const char c : name) {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 0x100000001b3ULL;
+    }
+    return Mix(hash);
+}
+
+size_t NameIndex::BucketOf(uint64_t hash) const {
+    return (hash >> 32) % seeds_.size();
+}
+
+size_t NameIndex::SlotOf(uint64_t hash, uint32_t seed, size_t slots) {
+    return Mix(hash ^ (seed * 0x9e3779b97f4a7c15ULL)) % slots;
+}
+
+NameIndex::NameIndex(const std::vector<Entry>& entries) {
+    if (entries.empty()) return;
+
+    const size_t slots = entries.size();
+    seeds_.assign(slots / NAMES_PER_BUCKET + 1, 0);
+
+    std::vector<std::vector<std::pair<uint64_t, uint32_t>>> buckets(seeds_.size());
+    for (const auto& [name, number] : entries) {
+        const uint64_t hash = Hash(name);
+        buckets[BucketOf(hash)].emplace_back(hash, number);
+    }
+
+    // the biggest buckets are placed first, while most slots are still free
+    std::vector<uint32_t> order(buckets.size());
+    for (uint32_t i = 0; i < order.size(); ++i) {
+        order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(), [&buckets](uint32_t lhs, uint32_t rhs) {
+        return buckets[lhs].size() > buckets[rhs].size();
+    });
+
+    numbers_.assign(slots, NO_NUMBER);
+    std::vector<size_t> bucket_slots;
+    for (const uint32_t bucket : order) {
+        if (buckets[bucket].empty()) break;
+
+        for (uint32_t seed = 0;; ++seed) {
+            if (seed == NO_NUMBER) {
+                // no seed fits, practically unreachable; the names are served by the map instead
+                seeds_.clear();
+                numbers_.clear();
+                for (const auto& [name, number] : entries) {
+                    added_.emplace(name, number);
+                }
+                return;
+            }
+            bucket_slots.clear();
+            bool fits = true;
+            for (const auto& [hash, number] : buckets[bucket]) {
+                const size_t slot = SlotOf(hash, seed, slots);
+                if (numbers_[slot] != NO_NUMBER
+                    || std::find(bucket_slots.begin(), bucket_slots.end(), slot) != bucket_slots.end()) {
+                    fits = false;
+                    break;
+                }
+                bucket_slots.push_back(slot);
+            }
+            if (fits) {
+                seeds_[bucket] = seed;
+                for (size_t i = 0; i < bucket_slots.size(); ++i) {
+                    numbers_[bucket_slots[i]] = buckets[bucket][i].second;
+                }
+                break;
+            }
+        }
+    }
+}
+
+NameIndex::NameIndex(const tc_serialize::PerfectHash& hash_pb)
+        : seeds_(hash_pb.seeds().begin(), hash_pb.seeds().end())
+        , numbers_(hash_pb.numbers().begin(), hash_pb.numbers().end()) {
+    if (seeds_.empty() != numbers_.empty()) {
+        seeds_.clear();
+        numbers_.clear();
+    }
+}
+
+NameIndex NameIndex::WithoutAdded() const {
+    NameIndex result;
+    result.seeds_ = seeds_;
+    result.numbers_ = numbers_;
+    return result;
+}
+
+void NameIndex::Add(std::string_view name, uint32_t number) {
+    added_[name] = number;
+}
+
+void NameIndex::Remove(std::string_view name) {
+    added_.erase(name);
+}
+
+void NameIndex::SaveTo(tc_serialize::PerfectHash& hash_pb) const {
+    hash_pb.mutable_seeds()->Add(seeds_.begin(), seeds_.end());
+    hash_pb.mutable_numbers()->Add(numbers_.begin(), numbers_.end());
+}
+
+memory::MemoryUsage NameIndex::MemoryUsage() const {
+    memory::MemoryUsage usage;
+    usage.Add("perfect_hash", memory::BytesOf(seeds_) + memory::BytesOf(numbers_));
+    usage.Add("added_names", memory::BytesOf(added_));
+    return usage;
+}
+
+} // namespace transport_catalogue
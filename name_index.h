@@ -0,0 +1,76 @@
+#pragma once
+
+#include "memory_usage.h"
+#include "transport_catalogue.pb.h"
+
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+
+namespace transport_catalogue {
+
+// Name -> number lookup. Names known when the base is built go to a minimal perfect hash
+// (CHD-style hash and displace: names are spread over small buckets, and every bucket gets a
+// seed that sends its names to free slots). Names added later go to an ordinary hash map.
+// The index keeps no names: the perfect hash gives exactly one candidate number, and the
+// caller checks that this number really has the name.
+class NameIndex {
+public:
+    using Entry = std::pair<std::string_view, uint32_t>;
+
+    NameIndex() = default;
+    // Builds the perfect hash, names must be unique
+    explicit NameIndex(const std::vector<Entry>& entries);
+    explicit NameIndex(const tc_serialize::PerfectHash& hash_pb);
+
+    // The perfect hash part only, names added later refer to strings of their owner
+    NameIndex WithoutAdded() const;
+
+    // name must outlive the index
+    void Add(std::string_view name, uint32_t number);
+    // Only names added later are forgotten. For the rest the caller stops confirming the number.
+    void Remove(std::string_view name);
+
+    // is_named(number) tells if number has this name
+    template <typename IsNamed>
+    std::optional<uint32_t> Find(std::string_view name, IsNamed is_named) const;
+
+    void SaveTo(tc_serialize::PerfectHash& hash_pb) const;
+    memory::MemoryUsage MemoryUsage() const;
+
+private:
+    std::vector<uint32_t> seeds_; // by bucket
+    std::vector<uint32_t> numbers_; // by slot
+    std::unordered_map<std::string_view, uint32_t> added_;
+
+    static uint64_t Hash(std::string_view name);
+    size_t BucketOf(uint64_t hash) const;
+    static size_t SlotOf(uint64_t hash, uint32_t seed, size_t slots);
+};
+
+
+template <typename IsNamed>
+std::optional<uint32_t> NameIndex::Find(std::string_view name, IsNamed is_named) const {
+    if (!numbers_.empty()) {
+        const uint64_t hash = Hash(name);
+        const uint32_t number = numbers_[SlotOf(hash, seeds_[BucketOf(hash)], numbers_.size())];
+        if (is_named(number)) {
+            return number;
+        }
+    }
+    if (added_.empty()) {
+        return std::nullopt;
+    }
+    const auto iter = added_.find(name);
+    if (iter == added_.end()) {
+        return std::nullopt;
+    }
+
+    return iter->second;
+}
+
+} // namespace transport_catalogue
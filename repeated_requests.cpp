@@ -0,0 +1,117 @@
+#include "repeated_requests.h"
+
+#include <unordered_map>
+#include <utility>
+
+using namespace std::literals;
+
+namespace {
+
+const json::Node* FindString(const json::Dict& dict, std::string_view key) {
+    const auto iter = dict.find(key);
+    return iter != dict.end() && iter->second.IsString() ? &iter->second : nullptr;
+}
+
+// Key of the query a request asks, empty for requests that are never merged.
+// Names are prefixed with their length, so different pairs of names never give the same key.
+std::string QueryKey(const json::Node& request) {
+    if (!request.IsDict()) return {};
+    const json::Dict& fields = request.AsDict();
+
+    const auto id = fields.find("id"sv);
+    const json::Node* type = FindString(fields, "type"sv);
+    if (id == fields.end() || !id->second.IsInt() || type == nullptr) return {};
+
+    std::vector<const json::Node*> names;
+    if (type->AsString() == "Bus"sv || type->AsString() == "Stop"sv) {
+        names = {FindString(fields, "name"sv)};
+    } else if (type->AsString() == "Route"sv) {
+        names = {FindString(fields, "from"sv), FindString(fields, "to"sv)};
+    } else {
+        return {};
+    }
+
+    std::string key(type->AsString());
+    for (const json::Node* name : names) {
+        if (name == nullptr) return {};
+
+        key += '/';
+        key += std::to_string(name->AsString().size());
+        key += ':';
+        key += name->AsString();
+    }
+
+    return key;
+}
+
+}  // namespace
+
+
+RepeatedRequests::RepeatedRequests(const json::Array& requests)
+        : query_of_(requests.size(), NONE)
+        , ids_(requests.size(), 0) {
+    std::unordered_map<std::string, size_t> query_by_key;
+
+    for (size_t i = 0; i < requests.size(); ++i) {
+        std::string key = QueryKey(requests[i]);
+        if (key.empty()) continue;
+
+        const auto [iter, added] = query_by_key.emplace(std::move(key), queries_.size());
+        if (added) {
+            Query query;
+            query.first = i;
+            queries_.push_back(std::move(query));
+        } else {
+            ++queries_[iter->second].repeats_left;
+        }
+        query_of_[i] = iter->second;
+        ids_[i] = requests[i].AsDict().at("id"s).AsInt();
+    }
+}
+
+bool RepeatedRequests::IsRepeat(size_t index) const {
+    const size_t query = query_of_[index];
+    return query != NONE && queries_[query].first != index;
+}
+
+bool RepeatedRequests::HasRepeats(size_t index) const {
+    const size_t query = query_of_[index];
+    return query != NONE && queries_[query].first == index && queries_[query].repeats_left > 0;
+}
+
+void RepeatedRequests::Keep(size_t index, std::string_view response) {
+    Query& query = queries_[query_of_[index]];
+
+    // the key goes as it is, quotes inside string values are always escaped, so it is found only once
+    size_t pos = response.find("\"request_id\":"sv);
+    if (pos == std::string_view::npos) return;
+    pos = response.find_first_not_of(' ', pos + "\"request_id\":"sv.size());
+    if (pos == std::string_view::npos) return;
+    const size_t end = response.find_first_not_of("-0123456789"sv, pos);
+
+    char number[json::MAX_NUMBER_CHARS];
+    const char* number_end = json::FormatNumber(ids_[index], number);
+    if (response.substr(pos, end - pos) != std::string_view(number, number_end - number)) return;
+
+    query.head = response.substr(0, pos);
+    query.tail = response.substr(end == std::string_view::npos ? response.size() : end);
+    query.kept = true;
+}
+
+bool RepeatedRequests::WriteRepeat(size_t index, json::Writer& writer) {
+    Query& query = queries_[query_of_[index]];
+    if (!query.kept) return false;
+
+    char number[json::MAX_NUMBER_CHARS];
+    std::string response = query.head;
+    response.append(number, json::FormatNumber(ids_[index], number));
+    response += query.tail;
+    writer.Raw(response);
+
+    if (--query.repeats_left == 0) {
+        query.head = std::string{};
+        query.tail = std::string{};
+        query.kept = false;
+    }
+    return true;
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "json.h"
+#include "json_writer.h"
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+
+// Finds Bus, Stop and Route requests of a batch that ask the same as an earlier one,
+// all but the id. The response to the first of them is kept as text, the later ones get
+// this text with their own request_id, so the query is answered only once.
+// A text is kept only while there are requests left to reuse it.
+class RepeatedRequests {
+public:
+    explicit RepeatedRequests(const json::Array& requests);
+
+    // an earlier request of the batch asks the same
+    bool IsRepeat(size_t index) const;
+    // the first of several requests that ask the same; its response is to be given to Keep()
+    bool HasRepeats(size_t index) const;
+
+    // response is the text written for the request at depth 1 of the output
+    void Keep(size_t index, std::string_view response);
+    // Writes the kept response with the own request_id. Returns false if nothing is kept,
+    // then the request has to be answered as usual.
+    bool WriteRepeat(size_t index, json::Writer& writer);
+
+private:
+    static constexpr size_t NONE = static_cast<size_t>(-1);
+
+    struct Query {
+        size_t first = 0;
+        // requests after the first one, which are not written yet
+        size_t repeats_left = 0;
+        bool kept = false;
+        // the response around the request_id value
+        std::string head;
+        std::string tail;
+    };
+
+    std::vector<Query> queries_;
+    // by request: its query in queries_ or NONE, and its id
+    std::vector<size_t> query_of_;
+    std::vector<int> ids_;
+};
@@ -10,7 +10,7 @@ std::optional<BusInfo> RequestHandler::GetBusStat(const std::string_view &bus_na
     return {bi};
 }
 
-const std::set<std::string_view> &RequestHandler::GetBusesByStop(const std::string_view &stop_name) const {
+TransportCatalogue::BusesRange RequestHandler::GetBusesByStop(const std::string_view &stop_name) const {
     return db_.GetBusesForStop(stop_name);
 }
 
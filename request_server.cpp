@@ -0,0 +1,156 @@
+#include "request_server.h"
+#include "json_writer.h"
+
+#include <charconv>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+using namespace std::literals;
+
+
+bool ReadFrame(std::istream& input, std::string& payload) {
+    std::string header;
+    if (!std::getline(input, header)) return false;
+    if (!header.empty() && header.back() == '\r') {
+        header.pop_back();
+    }
+
+    size_t length = 0;
+    const auto [end, error] = std::from_chars(header.data(), header.data() + header.size(), length);
+    if (error != std::errc{} || end != header.data() + header.size()) {
+        std::cerr << "Broken frame header: "sv << header << std::endl;
+        return false;
+    }
+
+    payload.resize(length);
+    input.read(payload.data(), static_cast<std::streamsize>(length));
+    if (static_cast<size_t>(input.gcount()) != length) {
+        std::cerr << "The input ended inside a frame."sv << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+void WriteFrame(std::ostream& output, std::string_view payload) {
+    output << payload.size() << '\n';
+    output.write(payload.data(), static_cast<std::streamsize>(payload.size()));
+    output.flush();
+}
+
+
+RequestServer::RequestServer(JsonReader& reader, CatalogueSnapshots& snapshots, std::string base_file, std::string delta_file,
+                             size_t threads)
+        : reader_(reader)
+        , snapshots_(snapshots)
+        , base_file_(std::move(base_file))
+        , delta_file_(std::move(delta_file))
+        , threads_(threads) {
+}
+
+RequestServer::~RequestServer() {
+    if (loader_.joinable()) {
+        loader_.join();
+    }
+}
+
+size_t RequestServer::Serve(std::istream& input, std::ostream& output) {
+    size_t batches = 0;
+    std::string request;
+    std::ostringstream response;
+
+    while (ReadFrame(input, request)) {
+        // the length goes first, so the whole response is gathered before it is sent
+        response.str({});
+        try {
+            const json::Document doc = json::Load(std::string_view(request));
+            const json::Node& root = doc.GetRoot();
+            if (root.IsDict() && root.AsDict().count("reload"sv) > 0) {
+                StartReload(root.AsDict().at("reload"sv), response);
+            } else {
+                reader_.AnswerBatch(root, response, threads_);
+                ++batches;
+            }
+        } catch (const std::exception& e) {
+            // a bad batch must not stop the server
+            std::cerr << e.what() << std::endl;
+            response.str({});
+            json::Writer writer(response);
+            writer.StartDict().Key("error_message"sv).Value(e.what()).EndDict();
+            writer.Flush();
+        }
+        WriteFrame(output, response.str());
+    }
+
+    return batches;
+}
+
+void RequestServer::StartReload(const json::Node& reload, std::ostream& response) {
+    if (!reload.IsDict()) {
+        throw json::ParsingError("Error reading the reload request.");
+    }
+    std::string file = base_file_;
+    if (const auto file_i = reload.AsDict().find("file"sv); file_i != reload.AsDict().end()) {
+        if (!file_i->second.IsString()) {
+            throw json::ParsingError("Error reading the reload request, file name data.");
+        }
+        file = file_i->second.AsString();
+    }
+
+    if (loading_) {
+        throw std::logic_error("Error reloading the base, another base is being loaded.");
+    }
+    if (loader_.joinable()) {
+        loader_.join();
+    }
+
+    loading_ = true;
+    loader_ = std::thread([this, file]() {
+        std::string message;
+        try {
+            std::ifstream input_file(file, std::ios::binary | std::ios::in);
+            tc_serialize::TransportCatalogue t_cat;
+            if (!input_file || !t_cat.ParseFromIstream(&input_file)) {
+                throw std::runtime_error("Error reading the base "s + file);
+            }
+            // batches in progress keep the previous version, it is freed when the last of them ends
+            const uint64_t number = snapshots_.Publish(delta_file_.empty() ? LoadCatalogueVersion(t_cat) : LoadWithDelta(t_cat));
+            message = "The base "s + file + (delta_file_.empty() ? ""s : " with the delta "s + delta_file_)
+                      + " is published as version "s + std::to_string(number);
+        } catch (const std::exception& e) {
+            message = e.what();
+        }
+        // the next reload may start as soon as this one is reported
+        loading_ = false;
+        std::cerr << message << std::endl;
+    });
+
+    json::Writer writer(response);
+    writer.StartDict().Key("file"sv).Value(file);
+    if (!delta_file_.empty()) {
+        writer.Key("delta"sv).Value(delta_file_);
+    }
+    writer.Key("reload"sv).Value("started"sv).EndDict();
+    writer.Flush();
+}
+
+std::shared_ptr<CatalogueVersion> RequestServer::LoadWithDelta(tc_serialize::TransportCatalogue& t_cat) const {
+    // the same steps as the load at the start, the version owns its catalogue
+    auto catalogue = std::make_shared<transport_catalogue::TransportCatalogue>();
+    if (!catalogue->RestoreFrom(t_cat)) {
+        throw std::runtime_error("Error restoring the transport catalogue from the base.");
+    }
+    JsonReader loader(*catalogue);
+    loader.RestoreFrom(t_cat);
+
+    std::ifstream delta_file(delta_file_);
+    if (!delta_file) {
+        throw std::runtime_error("Cannot open the delta file "s + delta_file_);
+    }
+    loader.ApplyDelta(delta_file);
+
+    auto version = loader.MakeCatalogueVersion();
+    version->catalogue = std::move(catalogue);
+    return version;
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "json_reader.h"
+#include "catalogue_snapshot.h"
+
+#include <atomic>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <thread>
+
+
+// Messages of the serve mode go in frames: the length of the payload in bytes as a decimal
+// number and '\n', then the payload itself.
+
+// Returns false when the input ends or the frame is broken
+bool ReadFrame(std::istream& input, std::string& payload);
+void WriteFrame(std::ostream& output, std::string_view payload);
+
+
+// Keeps answering batches of stat requests against the version published in snapshots,
+// the reader must use these snapshots.
+// Every request frame holds a JSON document with "stat_requests", its response frame holds the
+// array of responses, or {"error_message": ...} if the batch cannot be answered.
+// A frame {"reload": {"file": ...}} loads that base, {"reload": {}} the base_file again.
+// The delta_file of the settings, if any, is applied to a reloaded base the same way as at the start,
+// the response then names it in "delta".
+// The base is loaded in the background and published when it is ready; batches are answered
+// from the previous version meanwhile, each batch from the version taken when it starts.
+class RequestServer {
+public:
+    RequestServer(JsonReader& reader, CatalogueSnapshots& snapshots, std::string base_file, std::string delta_file,
+                  size_t threads);
+    RequestServer(const RequestServer&) = delete;
+    RequestServer& operator=(const RequestServer&) = delete;
+    // waits for the load in progress
+    ~RequestServer();
+
+    // Until the input ends, returns the number of answered batches
+    size_t Serve(std::istream& input, std::ostream& output);
+
+private:
+    JsonReader& reader_;
+    CatalogueSnapshots& snapshots_;
+    std::string base_file_;
+    std::string delta_file_; // empty if there is no delta
+    size_t threads_;
+    std::thread loader_;
+    std::atomic<bool> loading_ = false;
+
+    void StartReload(const json::Node& reload, std::ostream& response);
+    // restores the base and applies delta_file_ to it
+    std::shared_ptr<CatalogueVersion> LoadWithDelta(tc_serialize::TransportCatalogue& t_cat) const;
+};
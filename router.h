@@ -34,6 +34,8 @@ namespace graph {
 
         std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const;
 
+        memory::MemoryUsage MemoryUsage() const;
+
         struct RouteInternalData {
             Weight weight;
             std::optional<EdgeId> prev_edge;
@@ -184,6 +186,17 @@ namespace graph {
         }
     }
 
+    template <typename Weight>
+    memory::MemoryUsage Router<Weight>::MemoryUsage() const {
+        memory::MemoryUsage usage;
+        size_t matrix_bytes = memory::BytesOf(routes_internal_data_);
+        for (const auto& row : routes_internal_data_) {
+            matrix_bytes += memory::BytesOf(row);
+        }
+        usage.Add("routing_matrix", matrix_bytes);
+        return usage;
+    }
+
     template <typename Weight>
     std::optional<typename Router<Weight>::RouteInfo> Router<Weight>::BuildRoute(VertexId from,
                                                                                  VertexId to) const {
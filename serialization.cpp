@@ -32,11 +32,12 @@ geo::Coordinates DeserializeCoordinates(const tc_serialize::Coordinates& coords)
 }
 
 
-tc_serialize::DistanceBetweenStops SerializeDistance(uint32_t from, uint32_t to, int distance) {
+tc_serialize::DistanceBetweenStops SerializeDistance(uint32_t from, uint32_t to, int distance, bool implied) {
     tc_serialize::DistanceBetweenStops dbs;
     dbs.set_from_id(from);
     dbs.set_to_id(to);
     dbs.set_distance(distance);
+    dbs.set_implied(implied);
 
     return dbs;
 }
@@ -8,6 +8,7 @@
 
 struct SerializationSettings {
     std::string file_name;
+    std::string delta_file_name; // changes that process_requests applies on top of the base
 };
 
 struct RendererSettings;
@@ -20,7 +21,7 @@ tc_serialize::Coordinates SerializeCoordinates(const geo::Coordinates& coords);
 transport_catalogue::Stop DeserializeStop(const tc_serialize::Stop& stop);
 geo::Coordinates DeserializeCoordinates(const tc_serialize::Coordinates& coords);
 
-tc_serialize::DistanceBetweenStops SerializeDistance(uint32_t from, uint32_t to, int distance);
+tc_serialize::DistanceBetweenStops SerializeDistance(uint32_t from, uint32_t to, int distance, bool implied);
 
 tc_serialize::Point SerializePoint(const svg::Point& p);
 svg::Point DeserializePoint(const tc_serialize::Point& p);
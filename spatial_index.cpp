@@ -0,0 +1,255 @@
+#include "spatial_index.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+
+namespace transport_catalogue {
+
+namespace {
+
+// average number of stops in one grid cell
+const double STOPS_PER_CELL = 2.0;
+
+double MetersInLngDegree(double abs_lat) {
+    return geo::METERS_IN_DEGREE * std::cos(abs_lat * geo::DEGREE_TO_RAD);
+}
+
+}
+
+StopsSpatialIndex::StopsSpatialIndex(const TransportCatalogue& tc) {
+    const auto stops = tc.GetAllStopsIndex();
+    if (stops.empty()) {
+        cell_offsets_.assign(2, 0);
+        return;
+    }
+
+    double max_lat = (*stops.begin())->coordinates.lat;
+    double max_lng = (*stops.begin())->coordinates.lng;
+    min_lat_ = max_lat;
+    min_lng_ = max_lng;
+    for (const Stop* stop : stops) {
+        min_lat_ = std::min(min_lat_, stop->coordinates.lat);
+        max_lat = std::max(max_lat, stop->coordinates.lat);
+        min_lng_ = std::min(min_lng_, stop->coordinates.lng);
+        max_lng = std::max(max_lng, stop->coordinates.lng);
+    }
+    max_abs_lat_ = std::max(std::abs(min_lat_), std::abs(max_lat));
+
+    // the grid keeps cells roughly square in meters
+    const double height = std::max((max_lat - min_lat_) * geo::METERS_IN_DEGREE, 1.0);
+    const double width = std::max((max_lng - min_lng_) * MetersInLngDegree(max_abs_lat_), 1.0);
+    const double cells = std::max(1.0, static_cast<double>(stops.size()) / STOPS_PER_CELL);
+    rows_ = static_cast<uint32_t>(std::clamp(std::ceil(std::sqrt(cells * height / width)), 1.0, cells));
+    cols_ = static_cast<uint32_t>(std::max(1.0, std::ceil(cells / rows_)));
+    cell_lat_ = std::max((max_lat - min_lat_) / rows_, 1e-9);
+    cell_lng_ = std::max((max_lng - min_lng_) / cols_, 1e-9);
+
+    // counting sort of stops by cell, stops come in name order
+    std::vector<uint32_t> stop_cells;
+    stop_cells.reserve(stops.size());
+    cell_offsets_.assign(static_cast<size_t>(rows_) * cols_ + 1, 0);
+    for (const Stop* stop : stops) {
+        const uint32_t cell = RowOf(stop->coordinates.lat) * cols_ + ColOf(stop->coordinates.lng);
+        stop_cells.push_back(cell);
+        ++cell_offsets_[cell + 1];
+    }
+    for (size_t i = 1; i < cell_offsets_.size(); ++i) {
+        cell_offsets_[i] += cell_offsets_[i - 1];
+    }
+
+    cell_stops_.assign(stops.size(), nullptr);
+    std::vector<uint32_t> fill(cell_offsets_.begin(), cell_offsets_.end() - 1);
+    size_t stop_i = 0;
+    for (const Stop* stop : stops) {
+        cell_stops_[fill[stop_cells[stop_i++]]++] = stop;
+    }
+
+    cell_trig_.reserve(cell_stops_.size());
+    for (const Stop* stop : cell_stops_) {
+        cell_trig_.push_back(tc.GetStopTrig(stop->id));
+    }
+}
+
+StopsSpatialIndex::StopsSpatialIndex(const TransportCatalogue& tc, const tc_serialize::SpatialIndex& index_pb) :
+        min_lat_(index_pb.min_lat()), min_lng_(index_pb.min_lng()), cell_lat_(index_pb.cell_lat()),
+        cell_lng_(index_pb.cell_lng()), rows_(index_pb.rows()), cols_(index_pb.cols()), max_abs_lat_(index_pb.max_abs_lat()) {
+
+    if (static_cast<size_t>(index_pb.cell_offsets_size()) != static_cast<size_t>(rows_) * cols_ + 1) {
+        throw std::runtime_error("Error restoring the stops spatial index, the grid is corrupt.");
+    }
+    cell_offsets_.assign(index_pb.cell_offsets().begin(), index_pb.cell_offsets().end());
+
+    cell_stops_.reserve(index_pb.stop_ids_size());
+    for (const uint32_t stop_id : index_pb.stop_ids()) {
+        const Stop* stop = tc.GetStopById(stop_id);
+        if (stop == nullptr) {
+            throw std::runtime_error("Error restoring the stops spatial index, unknown stop id " + std::to_string(stop_id));
+        }
+        cell_stops_.push_back(stop);
+        cell_trig_.push_back(tc.GetStopTrig(stop_id));
+    }
+}
+
+void StopsSpatialIndex::SaveTo(tc_serialize::TransportCatalogue& t_cat) const {
+    tc_serialize::SpatialIndex out;
+
+    out.set_min_lat(min_lat_);
+    out.set_min_lng(min_lng_);
+    out.set_cell_lat(cell_lat_);
+    out.set_cell_lng(cell_lng_);
+    out.set_rows(rows_);
+    out.set_cols(cols_);
+    out.set_max_abs_lat(max_abs_lat_);
+    *out.mutable_cell_offsets() = {cell_offsets_.begin(), cell_offsets_.end()};
+    out.mutable_stop_ids()->Reserve(static_cast<int>(cell_stops_.size()));
+    for (const Stop* stop : cell_stops_) {
+        out.add_stop_ids(stop->id);
+    }
+
+    *(t_cat.mutable_base_settings()->mutable_spatial_index()) = std::move(out);
+}
+
+uint32_t StopsSpatialIndex::RowOf(double lat) const {
+    const double row = std::floor((lat - min_lat_) / cell_lat_);
+    return static_cast<uint32_t>(std::clamp(row, 0.0, static_cast<double>(rows_ - 1)));
+}
+
+uint32_t StopsSpatialIndex::ColOf(double lng) const {
+    const double col = std::floor((lng - min_lng_) / cell_lng_);
+    return static_cast<uint32_t>(std::clamp(col, 0.0, static_cast<double>(cols_ - 1)));
+}
+
+StopsSpatialIndex::CellRange StopsSpatialIndex::CellsOf(geo::Coordinates min, geo::Coordinates max) const {
+    return {RowOf(min.lat), RowOf(max.lat), ColOf(min.lng), ColOf(max.lng)};
+}
+
+template <typename Visitor>
+void StopsSpatialIndex::ForEachRangeInCells(CellRange range, Visitor&& visit) const {
+    for (uint32_t row = range.row_from; row <= range.row_to; ++row) {
+        const size_t cell_from = static_cast<size_t>(row) * cols_ + range.col_from;
+        const size_t cell_to = static_cast<size_t>(row) * cols_ + range.col_to;
+        // cells of a row go one after another, so their stops are one continuous range
+        if (cell_offsets_[cell_from] < cell_offsets_[cell_to + 1]) {
+            visit(cell_offsets_[cell_from], cell_offsets_[cell_to + 1]);
+        }
+    }
+}
+
+void StopsSpatialIndex::AddWithDistances(const geo::CoordinatesTrig& point, uint32_t first, uint32_t last,
+                                         std::vector<FoundStop>& result) const {
+    const size_t size_before = result.size();
+    std::vector<double> distances(last - first);
+    geo::ComputeDistancesFrom(point, cell_trig_.data() + first, distances.size(), distances.data());
+
+    result.resize(size_before + distances.size());
+    for (size_t i = 0; i < distances.size(); ++i) {
+        result[size_before + i] = {cell_stops_[first + i], distances[i]};
+    }
+}
+
+std::vector<StopsSpatialIndex::FoundStop> StopsSpatialIndex::FindNearest(geo::Coordinates point, size_t count) const {
+    std::vector<FoundStop> result;
+    if (count == 0 || cell_stops_.empty()) return result;
+
+    const auto by_distance = [](const FoundStop& lhs, const FoundStop& rhs) {
+        return lhs.distance < rhs.distance || (lhs.distance == rhs.distance && lhs.stop->stop_name < rhs.stop->stop_name);
+    };
+
+    // Rings of cells around the cell of the point are scanned outwards. Any stop beyond ring R
+    // is at least R cell sides away, so the search stops as soon as the count-th best is closer.
+    const double abs_lat = std::max(max_abs_lat_, std::abs(point.lat));
+    const double min_cell_side = std::min(cell_lat_ * geo::METERS_IN_DEGREE, cell_lng_ * MetersInLngDegree(abs_lat));
+    const int64_t row = RowOf(point.lat);
+    const int64_t col = ColOf(point.lng);
+    const int64_t max_ring = std::max(rows_, cols_);
+    const geo::CoordinatesTrig point_trig = geo::ComputeTrig(point);
+
+    const auto add_cells = [&](int64_t r_from, int64_t r_to, int64_t c_from, int64_t c_to) {
+        r_from = std::max<int64_t>(r_from, 0);
+        c_from = std::max<int64_t>(c_from, 0);
+        r_to = std::min<int64_t>(r_to, rows_ - 1);
+        c_to = std::min<int64_t>(c_to, cols_ - 1);
+        if (r_from > r_to || c_from > c_to) return;
+        ForEachRangeInCells({static_cast<uint32_t>(r_from), static_cast<uint32_t>(r_to), static_cast<uint32_t>(c_from),
+                             static_cast<uint32_t>(c_to)}, [&](uint32_t first, uint32_t last) {
+            AddWithDistances(point_trig, first, last, result);
+        });
+    };
+
+    for (int64_t ring = 0; ring <= max_ring; ++ring) {
+        if (ring == 0) {
+            add_cells(row, row, col, col);
+        } else {
+            add_cells(row - ring, row - ring, col - ring, col + ring); // top side
+            add_cells(row + ring, row + ring, col - ring, col + ring); // bottom side
+            add_cells(row - ring + 1, row + ring - 1, col - ring, col - ring); // left side
+            add_cells(row - ring + 1, row + ring - 1, col + ring, col + ring); // right side
+        }
+
+        if (result.size() >= count) {
+            std::nth_element(result.begin(), result.begin() + (count - 1), result.end(), by_distance);
+            result.resize(count);
+            if (result.back().distance <= ring * min_cell_side) break;
+        }
+    }
+
+    std::sort(result.begin(), result.end(), by_distance);
+    if (result.size() > count) result.resize(count);
+
+    return result;
+}
+
+std::vector<StopsSpatialIndex::FoundStop> StopsSpatialIndex::FindInRadius(geo::Coordinates point, double radius) const {
+    std::vector<FoundStop> result;
+    if (radius < 0.0 || cell_stops_.empty()) return result;
+
+    const double delta_lat = radius / geo::METERS_IN_DEGREE;
+    const double abs_lat = std::min(90.0, std::abs(point.lat) + delta_lat);
+    const double lng_meters = MetersInLngDegree(abs_lat);
+    // near the poles the circle can cover any longitude
+    const double delta_lng = lng_meters > 1.0 ? radius / lng_meters : 360.0;
+
+    const CellRange range = CellsOf({point.lat - delta_lat, point.lng - delta_lng}, {point.lat + delta_lat, point.lng + delta_lng});
+    const geo::CoordinatesTrig point_trig = geo::ComputeTrig(point);
+    ForEachRangeInCells(range, [&](uint32_t first, uint32_t last) {
+        AddWithDistances(point_trig, first, last, result);
+    });
+    result.erase(std::remove_if(result.begin(), result.end(), [radius](const FoundStop& found) {
+        return found.distance > radius;
+    }), result.end());
+
+    std::sort(result.begin(), result.end(), [](const FoundStop& lhs, const FoundStop& rhs) {
+        return lhs.distance < rhs.distance || (lhs.distance == rhs.distance && lhs.stop->stop_name < rhs.stop->stop_name);
+    });
+
+    return result;
+}
+
+std::vector<const Stop*> StopsSpatialIndex::FindInArea(geo::Coordinates min, geo::Coordinates max) const {
+    std::vector<const Stop*> result;
+    if (min.lat > max.lat || min.lng > max.lng || cell_stops_.empty()) return result;
+
+    ForEachRangeInCells(CellsOf(min, max), [&](uint32_t first, uint32_t last) {
+        for (uint32_t i = first; i < last; ++i) {
+            const geo::Coordinates& c = cell_stops_[i]->coordinates;
+            if (c.lat >= min.lat && c.lat <= max.lat && c.lng >= min.lng && c.lng <= max.lng) {
+                result.push_back(cell_stops_[i]);
+            }
+        }
+    });
+
+    std::sort(result.begin(), result.end(), [](const Stop* lhs, const Stop* rhs) { return lhs->stop_name < rhs->stop_name; });
+
+    return result;
+}
+
+memory::MemoryUsage StopsSpatialIndex::MemoryUsage() const {
+    memory::MemoryUsage usage;
+    usage.Add("grid_cells", memory::BytesOf(cell_offsets_) + memory::BytesOf(cell_stops_) + memory::BytesOf(cell_trig_));
+
+    return usage;
+}
+
+} // namespace transport_catalogue
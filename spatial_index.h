@@ -0,0 +1,65 @@
+#pragma once
+
+#include "geo.h"
+#include "domain.h"
+#include "transport_catalogue.h"
+#include "transport_catalogue.pb.h"
+
+#include <vector>
+
+
+namespace transport_catalogue {
+
+// Static uniform grid over stop coordinates, built once for a complete catalogue.
+// Stops of every cell are stored in CSR layout: the stops of cell N are
+// cell_stops_[cell_offsets_[N] .. cell_offsets_[N + 1]).
+class StopsSpatialIndex {
+public:
+    struct FoundStop {
+        const Stop* stop;
+        double distance;
+    };
+
+    explicit StopsSpatialIndex(const TransportCatalogue& tc);
+    // Restores the grid saved in the base, stop ids are resolved through the catalogue
+    StopsSpatialIndex(const TransportCatalogue& tc, const tc_serialize::SpatialIndex& index_pb);
+
+    void SaveTo(tc_serialize::TransportCatalogue& t_cat) const;
+
+    // count closest stops to the point, sorted by distance
+    std::vector<FoundStop> FindNearest(geo::Coordinates point, size_t count) const;
+    // stops not farther than radius meters from the point, sorted by distance
+    std::vector<FoundStop> FindInRadius(geo::Coordinates point, double radius) const;
+    // stops inside the coordinates rectangle, sorted by name
+    std::vector<const Stop*> FindInArea(geo::Coordinates min, geo::Coordinates max) const;
+
+    memory::MemoryUsage MemoryUsage() const;
+
+private:
+    struct CellRange {
+        uint32_t row_from, row_to, col_from, col_to;
+    };
+
+    double min_lat_ = 0.0;
+    double min_lng_ = 0.0;
+    double cell_lat_ = 1.0;
+    double cell_lng_ = 1.0;
+    uint32_t rows_ = 1;
+    uint32_t cols_ = 1;
+    double max_abs_lat_ = 0.0;
+
+    std::vector<uint32_t> cell_offsets_;
+    std::vector<const Stop*> cell_stops_;
+    std::vector<geo::CoordinatesTrig> cell_trig_; // trigonometry of cell_stops_, for the batch distance kernel
+
+    uint32_t RowOf(double lat) const;
+    uint32_t ColOf(double lng) const;
+    CellRange CellsOf(geo::Coordinates min, geo::Coordinates max) const;
+    // calls visit(first, last) for every continuous range of cell_stops_ inside the cells
+    template <typename Visitor>
+    void ForEachRangeInCells(CellRange range, Visitor&& visit) const;
+    // appends the stops of the range with their distances to the point
+    void AddWithDistances(const geo::CoordinatesTrig& point, uint32_t first, uint32_t last, std::vector<FoundStop>& result) const;
+};
+
+} // namespace transport_catalogue
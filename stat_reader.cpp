@@ -57,14 +57,14 @@ void StatisticReaderAndOutput::StopQueryAndPrint(std::string_view query_body, st
         out << "Stop "s << query_body << ": not found"s << std::endl;
         return;
     }
-    const std::set<std::string_view>& bus_routes = transport_catalogue_.GetBusesForStop(query_body);
+    const auto bus_routes = transport_catalogue_.GetBusesForStop(query_body);
     if (bus_routes.empty()) {
         out << "Stop "s << query_body << ": no buses"s << std::endl;
         return;
     }
     out << "Stop "s << query_body << ": buses "s;
     for (auto iter = bus_routes.begin(); iter != bus_routes.end(); ++iter) {
-        out << *iter;
+        out << (*iter)->bus_name;
         if (std::next(iter) != bus_routes.end()) {
             out << ' ';
         }
@@ -0,0 +1,152 @@
+// Checks ApplyDelta against a rebuild: a base restored from its serialized form and changed by
+// a delta must answer the same stat requests exactly as a base built from the changed data.
+// Returns 0 if every case answers the same.
+
+#include "json_reader.h"
+#include "transport_catalogue.h"
+
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <string_view>
+
+using namespace std::literals;
+
+namespace {
+
+const std::string SETTINGS = R"(
+    "routing_settings": {"bus_wait_time": 2, "bus_velocity": 30},
+    "render_settings": {"width": 600, "height": 400, "padding": 50, "stop_radius": 5, "line_width": 14,
+        "stop_label_font_size": 20, "stop_label_offset": [7, -3], "underlayer_color": [255, 255, 255, 0.85],
+        "underlayer_width": 3, "color_palette": ["green", [255, 160, 0], "red"],
+        "bus_label_font_size": 20, "bus_label_offset": [7, 15]},
+    "serialization_settings": {"file": "delta_test.db"})";
+
+// A -> B is stated and B -> A implied from it
+const std::string BASE_REQUESTS = R"(
+    {"type": "Stop", "name": "A", "latitude": 55.60, "longitude": 37.20, "road_distances": {"B": 1000}},
+    {"type": "Stop", "name": "B", "latitude": 55.61, "longitude": 37.21, "road_distances": {"C": 1500}},
+    {"type": "Stop", "name": "C", "latitude": 55.62, "longitude": 37.22, "road_distances": {"B": 1800}},
+    {"type": "Bus", "name": "1", "stops": ["A", "B", "C"], "is_roundtrip": false},
+    {"type": "Bus", "name": "2", "stops": ["C", "B", "C"], "is_roundtrip": true})";
+
+const std::string STAT_REQUESTS = R"({"stat_requests": [
+    {"id": 1, "type": "Bus", "name": "1"},
+    {"id": 2, "type": "Bus", "name": "2"},
+    {"id": 3, "type": "Bus", "name": "3"},
+    {"id": 4, "type": "Stop", "name": "B"},
+    {"id": 5, "type": "Stop", "name": "D"},
+    {"id": 6, "type": "Route", "from": "A", "to": "C"},
+    {"id": 7, "type": "Route", "from": "C", "to": "A"},
+    {"id": 8, "type": "Route", "from": "B", "to": "A"},
+    {"id": 9, "type": "Map"}
+]})";
+
+struct Case {
+    std::string_view name;
+    std::string delta_requests;
+    // the base requests of the same data built from scratch
+    std::string rebuilt_requests;
+};
+
+std::string Answer(JsonReader& reader) {
+    const json::Document requests = json::Load(std::string_view(STAT_REQUESTS));
+    std::ostringstream out;
+    reader.AnswerBatch(requests.GetRoot(), out);
+    return out.str();
+}
+
+std::string DeltaAnswer(const Case& test) {
+    transport_catalogue::TransportCatalogue base;
+    JsonReader base_reader(base);
+    std::istringstream base_input("{\"base_requests\": ["s + BASE_REQUESTS + "]," + SETTINGS + "}");
+    base_reader.ReadJsonToTransportCatalogue(base_input);
+    tc_serialize::TransportCatalogue t_cat;
+    base.SaveTo(t_cat);
+    base_reader.SaveTo(t_cat);
+
+    transport_catalogue::TransportCatalogue tc;
+    JsonReader reader(tc);
+    tc.RestoreFrom(t_cat);
+    reader.RestoreFrom(t_cat);
+    // answered once before the delta, so a version made of the old data is kept by the reader
+    Answer(reader);
+
+    std::istringstream delta("{\"delta_requests\": ["s + test.delta_requests + "]}");
+    reader.ApplyDelta(delta);
+    return Answer(reader);
+}
+
+std::string RebuiltAnswer(const Case& test) {
+    transport_catalogue::TransportCatalogue tc;
+    JsonReader reader(tc);
+    std::istringstream input("{\"base_requests\": ["s + test.rebuilt_requests + "]," + SETTINGS + "}");
+    reader.ReadJsonToTransportCatalogue(input);
+    return Answer(reader);
+}
+
+// the first line that differs, as it is in both answers
+std::string FirstDifference(const std::string& delta, const std::string& rebuilt) {
+    std::istringstream delta_lines(delta);
+    std::istringstream rebuilt_lines(rebuilt);
+    std::string delta_line;
+    std::string rebuilt_line;
+    while (true) {
+        const bool delta_more = static_cast<bool>(std::getline(delta_lines, delta_line));
+        const bool rebuilt_more = static_cast<bool>(std::getline(rebuilt_lines, rebuilt_line));
+        if (!delta_more && !rebuilt_more) return {};
+        if (!delta_more) delta_line.clear();
+        if (!rebuilt_more) rebuilt_line.clear();
+        if (delta_line != rebuilt_line) break;
+    }
+    return "delta:   "s + delta_line + "\nrebuilt: "s + rebuilt_line;
+}
+
+}  // namespace
+
+int main() {
+    const Case cases[] = {
+        {"distance only"sv,
+         R"({"type": "Stop", "name": "A", "road_distances": {"B": 2000}})",
+         R"({"type": "Stop", "name": "A", "latitude": 55.60, "longitude": 37.20, "road_distances": {"B": 2000}},
+            {"type": "Stop", "name": "B", "latitude": 55.61, "longitude": 37.21, "road_distances": {"C": 1500}},
+            {"type": "Stop", "name": "C", "latitude": 55.62, "longitude": 37.22, "road_distances": {"B": 1800}},
+            {"type": "Bus", "name": "1", "stops": ["A", "B", "C"], "is_roundtrip": false},
+            {"type": "Bus", "name": "2", "stops": ["C", "B", "C"], "is_roundtrip": true})"},
+        {"stated reverse distance kept"sv,
+         R"({"type": "Stop", "name": "B", "road_distances": {"C": 900}})",
+         R"({"type": "Stop", "name": "A", "latitude": 55.60, "longitude": 37.20, "road_distances": {"B": 1000}},
+            {"type": "Stop", "name": "B", "latitude": 55.61, "longitude": 37.21, "road_distances": {"C": 900}},
+            {"type": "Stop", "name": "C", "latitude": 55.62, "longitude": 37.22, "road_distances": {"B": 1800}},
+            {"type": "Bus", "name": "1", "stops": ["A", "B", "C"], "is_roundtrip": false},
+            {"type": "Bus", "name": "2", "stops": ["C", "B", "C"], "is_roundtrip": true})"},
+        {"moved and new stops, buses"sv,
+         R"({"type": "Stop", "name": "C", "latitude": 55.63, "longitude": 37.25, "road_distances": {"D": 700}},
+            {"type": "Stop", "name": "D", "latitude": 55.64, "longitude": 37.26, "road_distances": {}},
+            {"type": "RemoveBus", "name": "2"},
+            {"type": "Bus", "name": "3", "stops": ["B", "C", "D", "B"], "is_roundtrip": true},
+            {"type": "Bus", "name": "1", "stops": ["A", "B", "C", "D"], "is_roundtrip": false},
+            {"type": "Stop", "name": "D", "road_distances": {"B": 2500}})",
+         R"({"type": "Stop", "name": "A", "latitude": 55.60, "longitude": 37.20, "road_distances": {"B": 1000}},
+            {"type": "Stop", "name": "B", "latitude": 55.61, "longitude": 37.21, "road_distances": {"C": 1500}},
+            {"type": "Stop", "name": "C", "latitude": 55.63, "longitude": 37.25, "road_distances": {"B": 1800, "D": 700}},
+            {"type": "Stop", "name": "D", "latitude": 55.64, "longitude": 37.26, "road_distances": {"B": 2500}},
+            {"type": "Bus", "name": "1", "stops": ["A", "B", "C", "D"], "is_roundtrip": false},
+            {"type": "Bus", "name": "3", "stops": ["B", "C", "D", "B"], "is_roundtrip": true})"},
+    };
+
+    bool ok = true;
+    for (const Case& test : cases) {
+        const std::string delta = DeltaAnswer(test);
+        const std::string rebuilt = RebuiltAnswer(test);
+        const bool same = delta == rebuilt;
+        std::cout << test.name << (same ? ": OK"sv : ": FAILED"sv) << std::endl;
+        if (!same) {
+            std::cout << FirstDifference(delta, rebuilt) << std::endl;
+        }
+        ok = ok && same;
+    }
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
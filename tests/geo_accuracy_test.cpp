@@ -0,0 +1,127 @@
+// Checks the batch haversine kernels: the SIMD results against the scalar ones,
+// and both against the acos formula of geo::ComputeDistance.
+// Returns 0 if every pair is within the tolerances below.
+
+#include "geo.h"
+#include "cpu_features.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string_view>
+#include <vector>
+
+using namespace std::literals;
+
+namespace {
+
+// SIMD against scalar: the same formula, the products are grouped differently,
+// so only the last bits may differ
+const double KERNEL_TOLERANCE = 1e-12;
+// haversine against acos: near 1 acos turns the rounding of its argument into an angle
+// error of about sqrt(2 * 1e-16) radians, some 0.1 m on the ground, so pairs closer than
+// ACOS_NEAR are compared with the absolute tolerance instead
+const double ACOS_TOLERANCE = 1e-6;
+const double ACOS_NEAR = 1000.0; // meters
+const double ACOS_NEAR_TOLERANCE = 0.5; // meters
+
+struct Pairs {
+    std::vector<geo::Coordinates> from;
+    std::vector<geo::Coordinates> to;
+};
+
+// pairs from 1 cm to half of the globe apart, anywhere but the poles
+Pairs MakePairs(size_t count) {
+    std::mt19937_64 random(42);
+    std::uniform_real_distribution<double> lat(-85.0, 85.0);
+    std::uniform_real_distribution<double> lng(-180.0, 180.0);
+    std::uniform_real_distribution<double> log_offset(-7.0, 1.0); // degrees, 1e-7 .. 10
+    std::uniform_real_distribution<double> sign(-1.0, 1.0);
+
+    Pairs pairs;
+    for (size_t i = 0; i < count; ++i) {
+        const geo::Coordinates from {lat(random), lng(random)};
+        geo::Coordinates to {lat(random), lng(random)};
+        if (i % 2 == 0) {
+            to = {std::clamp(from.lat + sign(random) * std::pow(10.0, log_offset(random)), -89.0, 89.0),
+                  from.lng + sign(random) * std::pow(10.0, log_offset(random))};
+        }
+        pairs.from.push_back(from);
+        pairs.to.push_back(to);
+    }
+    return pairs;
+}
+
+std::vector<geo::CoordinatesTrig> ToTrig(const std::vector<geo::Coordinates>& points) {
+    std::vector<geo::CoordinatesTrig> result;
+    result.reserve(points.size());
+    for (const geo::Coordinates& point : points) {
+        result.push_back(geo::ComputeTrig(point));
+    }
+    return result;
+}
+
+double RelativeError(double value, double reference) {
+    return reference == 0.0 ? std::abs(value) : std::abs(value - reference) / reference;
+}
+
+// Pairs closer than near are checked with the absolute near_tolerance, the others with
+// the relative tolerance. Prints the worst errors, returns false if a pair is out of its tolerance.
+bool Check(std::string_view name, const std::vector<double>& values, const std::vector<double>& reference,
+           double tolerance, double near = 0.0, double near_tolerance = 0.0) {
+    double worst_relative = 0.0;
+    double worst_near = 0.0;
+    for (size_t i = 0; i < values.size(); ++i) {
+        if (reference[i] < near) {
+            worst_near = std::max(worst_near, std::abs(values[i] - reference[i]));
+        } else {
+            worst_relative = std::max(worst_relative, RelativeError(values[i], reference[i]));
+        }
+    }
+
+    const bool ok = worst_relative <= tolerance && worst_near <= near_tolerance;
+    std::cout << name << ": max relative error "sv << worst_relative << " (tolerance "sv << tolerance << ")"sv;
+    if (near > 0.0) {
+        std::cout << ", below "sv << near << " m max error "sv << worst_near << " m (tolerance "sv << near_tolerance << " m)"sv;
+    }
+    std::cout << (ok ? " OK"sv : " FAILED"sv) << std::endl;
+    return ok;
+}
+
+}  // namespace
+
+int main() {
+    // an odd count, so the scalar tail after the groups of four is checked too
+    const Pairs pairs = MakePairs(100003);
+    const auto from = ToTrig(pairs.from);
+    const auto to = ToTrig(pairs.to);
+    const size_t count = from.size();
+
+    std::cout << "AVX2 kernels: "sv << (cpu::HasAvx2() ? "on"sv : "not supported, scalar only"sv) << std::endl;
+
+    std::vector<double> scalar(count);
+    geo::ComputeDistancesScalar(from.data(), to.data(), count, scalar.data());
+
+    std::vector<double> pairwise(count);
+    geo::ComputeDistances(from.data(), to.data(), count, pairwise.data());
+
+    // one point to all others, against the pairwise scalar results with the same first point
+    std::vector<double> from_one(count);
+    geo::ComputeDistancesFrom(from[0], to.data(), count, from_one.data());
+    const std::vector<geo::CoordinatesTrig> first_repeated(count, from[0]);
+    std::vector<double> from_one_scalar(count);
+    geo::ComputeDistancesScalar(first_repeated.data(), to.data(), count, from_one_scalar.data());
+
+    std::vector<double> acos(count);
+    for (size_t i = 0; i < count; ++i) {
+        acos[i] = geo::ComputeDistance(pairs.from[i], pairs.to[i]);
+    }
+
+    bool ok = Check("pairwise against scalar"sv, pairwise, scalar, KERNEL_TOLERANCE);
+    ok = Check("from one point against scalar"sv, from_one, from_one_scalar, KERNEL_TOLERANCE) && ok;
+    ok = Check("scalar against acos"sv, scalar, acos, ACOS_TOLERANCE, ACOS_NEAR, ACOS_NEAR_TOLERANCE) && ok;
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -4,9 +4,129 @@
 #include <iostream>
 #include <set>
 #include <iomanip>
+#include <algorithm>
+#include <atomic>
 
 namespace transport_catalogue{
 
+namespace {
+
+// the room of a stop range of the stop -> buses index when it moves for the first time
+const uint32_t MIN_STOP_BUSES_CAPACITY = 4;
+
+// Buffers of GetBusInfo, one set per thread
+struct BusInfoScratch {
+    std::vector<uint32_t> stop_ids;
+    std::vector<geo::CoordinatesTrig> points;
+    std::vector<double> distances;
+};
+
+BusInfoScratch& GetBusInfoScratch() {
+    thread_local BusInfoScratch scratch;
+    return scratch;
+}
+
+// A shared block may only lose its other owners meanwhile: catalogues are copied by the writer
+// alone, and a block it sees unshared stays so. The fence makes the reads of the former owners
+// happen before the changes.
+template <typename Data>
+bool IsShared(const std::shared_ptr<Data>& data) {
+    if (data.use_count() > 1) return true;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return false;
+}
+
+}  // namespace
+
+
+TransportCatalogue::StopsData& TransportCatalogue::MutableStops() {
+    if (!IsShared(stops_)) return *stops_;
+
+    // stop ids are kept, so the perfect hash of the stops stays valid for the copy
+    const StopsData& other = *stops_;
+    auto stops = std::make_shared<StopsData>();
+    stops->id_counter = other.id_counter;
+    stops->names = other.names.WithoutAdded();
+    stops->by_id.resize(other.by_id.size(), nullptr);
+    stops->trig = other.trig;
+    for (const Stop& stop : other.stops) {
+        Stop* ptr = &stops->stops.emplace_back(stop);
+        stops->by_id[ptr->id] = ptr;
+        if (!stops->names.Find(ptr->stop_name, [&](uint32_t id) { return id == ptr->id; })) {
+            stops->names.Add(ptr->stop_name, ptr->id);
+        }
+    }
+    stops->sorted.reserve(other.sorted.size());
+    for (const Stop* stop : other.sorted) {
+        stops->sorted.push_back(stops->by_id[stop->id]);
+    }
+    stops_ = std::move(stops);
+
+    // the buses refer to the stops, shared buses are copied and own ones pointed at the new stops
+    if (IsShared(buses_)) {
+        buses_ = CopyBuses(*buses_, *stops_);
+    } else {
+        for (BusRoute& route : buses_->routes) {
+            for (const Stop*& stop : route.route_stops) {
+                stop = stops_->by_id[stop->id];
+            }
+        }
+    }
+
+    return *stops_;
+}
+
+TransportCatalogue::DistancesIndex& TransportCatalogue::MutableDistances() {
+    if (IsShared(distances_)) {
+        distances_ = std::make_shared<DistancesIndex>(*distances_);
+    }
+    return *distances_;
+}
+
+TransportCatalogue::BusesData& TransportCatalogue::MutableBuses() {
+    if (IsShared(buses_)) {
+        buses_ = CopyBuses(*buses_, *stops_);
+    }
+    return *buses_;
+}
+
+std::shared_ptr<TransportCatalogue::BusesData> TransportCatalogue::CopyBuses(const BusesData& other, const StopsData& stops) {
+    auto buses = std::make_shared<BusesData>();
+
+    // removed buses are left out. Without them the bus numbers and the perfect hash stay valid,
+    // with them the live buses are numbered anew and the perfect hash is built for the new numbers.
+    const bool renumber = std::find(other.removed.begin(), other.removed.end(), true) != other.removed.end();
+    if (!renumber) {
+        buses->names = other.names.WithoutAdded();
+    }
+    for (size_t number = 0; number < other.routes.size(); ++number) {
+        if (IsBusRemoved(other, number)) continue;
+
+        const BusRoute& route = other.routes[number];
+        BusRoute& own = buses->routes.emplace_back(BusRoute{route.bus_name, route.type, {}});
+        own.route_stops.reserve(route.route_stops.size());
+        for (const Stop* stop : route.route_stops) {
+            own.route_stops.push_back(stops.by_id[stop->id]);
+        }
+        const uint32_t own_number = static_cast<uint32_t>(buses->routes.size() - 1);
+        if (!renumber && !buses->names.Find(own.bus_name, [own_number](uint32_t n) { return n == own_number; })) {
+            buses->names.Add(own.bus_name, own_number);
+        }
+    }
+    if (renumber) {
+        std::vector<NameIndex::Entry> entries;
+        entries.reserve(buses->routes.size());
+        for (size_t number = 0; number < buses->routes.size(); ++number) {
+            entries.emplace_back(buses->routes[number].bus_name, static_cast<uint32_t>(number));
+        }
+        buses->names = NameIndex(entries);
+    }
+
+    SortBusNames(*buses);
+    BuildStopBusesIndex(*buses, stops.by_id.size());
+
+    return buses;
+}
 
 void TransportCatalogue::AddStop(const std::string& name, const geo::Coordinates coords) {
     const Stop stop {0, name, coords};
@@ -15,76 +135,481 @@ void TransportCatalogue::AddStop(const std::string& name, const geo::Coordinates
 }
 
 void TransportCatalogue::AddStop(const Stop& stop) {
-    if (stops_index_.count(stop.stop_name) > 0) return;
+    const Stop* ptr = EmplaceStop(Stop{stop});
+    if (ptr == nullptr) return;
+
+    std::vector<const Stop*>& sorted_stops = stops_->sorted;
+    // in a batch the new stops wait at the end, FinishBatch sorts them in
+    if (batch_) {
+        sorted_stops.push_back(ptr);
+        return;
+    }
+    const auto pos = std::lower_bound(sorted_stops.begin(), sorted_stops.end(), ptr->stop_name,
+                                      [](const Stop* lhs, std::string_view rhs) { return lhs->stop_name < rhs; });
+    sorted_stops.insert(pos, ptr);
+}
 
-    Stop* ptr = &stops_.emplace_back(stop);
+std::pair<bool, const Stop&> TransportCatalogue::FindStop(const std::string_view name) const {
+    const Stop* stop = FindStopByName(name);
+    if (stop == nullptr) return {false, EMPTY_STOP};
+
+    return {true, *stop};
+}
+
+bool TransportCatalogue::AddBus(const BusRoute &bus_route) {
+    const BusRoute* ptr = EmplaceBus(BusRoute{bus_route});
+    if (ptr == nullptr) return false;
+
+    std::vector<const BusRoute*>& sorted_routes = buses_->sorted;
+    if (batch_) {
+        sorted_routes.push_back(ptr);
+    } else {
+        const auto pos = std::lower_bound(sorted_routes.begin(), sorted_routes.end(), ptr->bus_name,
+                                          [](const BusRoute* lhs, std::string_view rhs) { return lhs->bus_name < rhs; });
+        sorted_routes.insert(pos, ptr);
+    }
+
+    AddBusToStopsIndex(ptr);
+
+    return true;
+}
+
+size_t TransportCatalogue::BulkLoad(std::vector<StopWithDistances>&& stops, std::vector<BusWithStopNames>&& buses) {
+    size_t rejected = 0;
+    ++routing_revision_;
+
+    // Phase 1: stops. Every index is reserved for its final size up front.
+    StopsData& stops_data = MutableStops();
+    stops_data.by_id.reserve(stops_data.by_id.size() + stops.size() + 1);
+
+    size_t distances_count = 0;
+    std::vector<const Stop*> loaded_stops(stops.size(), nullptr);
+    for (size_t i = 0; i < stops.size(); ++i) {
+        distances_count += stops[i].distances.size();
+        loaded_stops[i] = EmplaceStop(Stop{stops[i].id, std::move(stops[i].stop_name), stops[i].coordinates});
+        if (loaded_stops[i] == nullptr) ++rejected;
+    }
+
+    // Phase 2: distances. Explicit distances go first and the reverse pairs only fill the gaps
+    // afterwards, which gives the same result as SetDistanceBetweenStops called one by one.
+    std::vector<std::pair<StopIdsPair, int>> distances;
+    distances.reserve(distances_count);
+    for (size_t i = 0; i < stops.size(); ++i) {
+        if (loaded_stops[i] == nullptr) continue;
+        for (const auto& [other_name, distance] : stops[i].distances) {
+            const Stop* other = FindStopByName(other_name);
+            if (other == nullptr) {
+                ++rejected;
+                continue;
+            }
+            distances.emplace_back(StopIdsPair{loaded_stops[i]->id, other->id}, static_cast<int>(distance));
+        }
+    }
+    DistancesIndex& distance_index = MutableDistances();
+    distance_index.reserve(distance_index.size() + 2 * distances.size());
+    for (const auto& [direct, distance] : distances) {
+        distance_index[direct] = PairDistance{distance, false};
+    }
+    for (const auto& [direct, distance] : distances) {
+        distance_index.emplace(StopIdsPair{direct.other, direct.stop}, PairDistance{distance, true});
+    }
+
+    // Phase 3: buses, stop names resolved to pointers
+    for (BusWithStopNames& bus : buses) {
+        BusRoute route {std::move(bus.bus_name), bus.type, {}};
+        route.route_stops.reserve(bus.route_stops.size());
+        for (const std::string& stop_name : bus.route_stops) {
+            const Stop* stop = FindStopByName(stop_name);
+            if (stop == nullptr) break;
+            route.route_stops.push_back(stop);
+        }
+        if (route.route_stops.size() != bus.route_stops.size() || EmplaceBus(std::move(route)) == nullptr) {
+            ++rejected;
+        }
+    }
+
+    // Phase 4: secondary indexes are built once for the whole catalogue
+    RebuildSecondaryIndexes();
+
+    return rejected;
+}
+
+const Stop* TransportCatalogue::FindStopByName(std::string_view name) const {
+    const StopsData& stops = *stops_;
+    const auto id = stops.names.Find(name, [&stops, name](uint32_t id) {
+        return id < stops.by_id.size() && stops.by_id[id] != nullptr && stops.by_id[id]->stop_name == name;
+    });
+
+    return id ? stops.by_id[*id] : nullptr;
+}
+
+std::optional<uint32_t> TransportCatalogue::FindBusNumber(std::string_view name) const {
+    const BusesData& buses = *buses_;
+    return buses.names.Find(name, [&buses, name](uint32_t number) {
+        return number < buses.routes.size() && !IsBusRemoved(buses, number) && buses.routes[number].bus_name == name;
+    });
+}
+
+const BusRoute* TransportCatalogue::FindBusByName(std::string_view name) const {
+    const auto number = FindBusNumber(name);
+
+    return number ? &buses_->routes[*number] : nullptr;
+}
+
+const Stop* TransportCatalogue::EmplaceStop(Stop&& stop) {
+    if (FindStopByName(stop.stop_name) != nullptr) return nullptr;
+
+    StopsData& stops = MutableStops();
+    ++routing_revision_;
+    Stop* ptr = &stops.stops.emplace_back(std::move(stop));
 
     if (ptr->id == 0){ // if we created the stop from Raw data in JSON
-        ptr->id = ++stop_id_counter_;
+        ptr->id = ++stops.id_counter;
     } else {
-        stop_id_counter_ = ptr->id;
+        stops.id_counter = std::max(stops.id_counter, ptr->id);
     }
-    std::string_view stop_name(ptr->stop_name); // string_view must point to permanent string, that will not disappear.
-    stops_index_.emplace(stop_name, ptr);
-    stop_id_name_index_.emplace(ptr->id, ptr);
+    RegisterStopId(stops, ptr);
+    // stops restored from a base are already known to the perfect hash
+    if (FindStopByName(ptr->stop_name) != ptr) {
+        stops.names.Add(ptr->stop_name, ptr->id); // the name lives in the deque, its address never changes
+    }
+
+    return ptr;
 }
 
-std::pair<bool, const Stop&> TransportCatalogue::FindStop(const std::string_view name) const {
-    const auto iter = stops_index_.find(name);
-    if (iter == stops_index_.end()) return {false, EMPTY_STOP};
+const BusRoute* TransportCatalogue::EmplaceBus(BusRoute&& bus_route) {
+    if (FindBusByName(bus_route.bus_name) != nullptr) return nullptr;
+
+    BusesData& buses = MutableBuses();
+    ++routing_revision_;
+    const BusRoute* ptr = &buses.routes.emplace_back(std::move(bus_route));
 
-    return {true, *iter->second};
+    if (FindBusByName(ptr->bus_name) != ptr) {
+        buses.names.Add(ptr->bus_name, static_cast<uint32_t>(buses.routes.size() - 1));
+    }
+
+    return ptr;
 }
 
-bool TransportCatalogue::AddBus(const BusRoute &bus_route) {
-    const auto iter = routes_index_.find(bus_route.bus_name);
-    if (iter != routes_index_.end()) return false;
+bool TransportCatalogue::IsBusRemoved(size_t number) const {
+    return IsBusRemoved(*buses_, number);
+}
+
+bool TransportCatalogue::IsBusRemoved(const BusesData& buses, size_t number) {
+    return number < buses.removed.size() && buses.removed[number];
+}
+
+bool TransportCatalogue::RemoveBus(std::string_view name) {
+    if (!FindBusNumber(name)) return false;
+    BusesData& buses = MutableBuses();
+    ++routing_revision_;
+    const uint32_t number = *FindBusNumber(name); // the number in the copy, if the buses were copied
+    BusRoute* bus = &buses.routes[number];
+
+    RemoveBusFromStopsIndex(bus);
+    if (batch_) {
+        batch_removed_routes_.push_back(bus);
+    } else {
+        const auto pos = std::lower_bound(buses.sorted.begin(), buses.sorted.end(), bus->bus_name,
+                                          [](const BusRoute* lhs, std::string_view rhs) { return lhs->bus_name < rhs; });
+        buses.sorted.erase(pos);
+    }
+    buses.names.Remove(bus->bus_name);
+
+    // the bus stays in the deque as an empty tombstone, the addresses and numbers of the others do not change
+    if (buses.removed.size() <= number) {
+        buses.removed.resize(number + 1, false);
+    }
+    buses.removed[number] = true;
+    bus->bus_name.clear();
+    bus->bus_name.shrink_to_fit();
+    bus->route_stops.clear();
+    bus->route_stops.shrink_to_fit();
+
+    return true;
+}
+
+void TransportCatalogue::StartBatch() {
+    batch_ = true;
+    batch_sorted_stops_ = stops_->sorted.size();
+    batch_sorted_routes_ = buses_->sorted.size();
+}
+
+void TransportCatalogue::FinishBatch() {
+    if (!batch_) return;
+    batch_ = false;
+
+    // the added part is sorted on its own and merged with the sorted one, O(N + K log K) for K additions.
+    // Without changes the shared data is left alone.
+    if (stops_->sorted.size() != batch_sorted_stops_) {
+        std::vector<const Stop*>& sorted_stops = MutableStops().sorted;
+        const auto by_stop_name = [](const Stop* lhs, const Stop* rhs) { return lhs->stop_name < rhs->stop_name; };
+        const auto stops_added = sorted_stops.begin() + batch_sorted_stops_;
+        std::sort(stops_added, sorted_stops.end(), by_stop_name);
+        std::inplace_merge(sorted_stops.begin(), stops_added, sorted_stops.end(), by_stop_name);
+    }
 
-    const BusRoute* ptr = &bus_routes_.emplace_back(bus_route);
+    if (batch_removed_routes_.empty() && buses_->sorted.size() == batch_sorted_routes_) return;
+    std::vector<const BusRoute*>& sorted_routes = MutableBuses().sorted;
+
+    // the removed buses leave both parts, which keep their order
+    if (!batch_removed_routes_.empty()) {
+        std::sort(batch_removed_routes_.begin(), batch_removed_routes_.end());
+        const auto is_removed = [this](const BusRoute* route) {
+            return std::binary_search(batch_removed_routes_.begin(), batch_removed_routes_.end(), route);
+        };
+        const auto removed_sorted = std::count_if(sorted_routes.begin(), sorted_routes.begin() + batch_sorted_routes_, is_removed);
+        batch_sorted_routes_ -= static_cast<size_t>(removed_sorted);
+        sorted_routes.erase(std::remove_if(sorted_routes.begin(), sorted_routes.end(), is_removed), sorted_routes.end());
+        batch_removed_routes_.clear();
+    }
+
+    const auto by_bus_name = [](const BusRoute* lhs, const BusRoute* rhs) { return lhs->bus_name < rhs->bus_name; };
+    const auto routes_added = sorted_routes.begin() + batch_sorted_routes_;
+    std::sort(routes_added, sorted_routes.end(), by_bus_name);
+    std::inplace_merge(sorted_routes.begin(), routes_added, sorted_routes.end(), by_bus_name);
+}
+
+bool TransportCatalogue::ReplaceBus(const BusRoute& bus_route) {
+    RemoveBus(bus_route.bus_name);
+
+    return AddBus(bus_route);
+}
+
+bool TransportCatalogue::UpdateStopCoordinates(std::string_view name, geo::Coordinates coords) {
+    if (FindStopByName(name) == nullptr) return false;
+
+    // the routing graph does not depend on the coordinates, the revision stays
+    StopsData& stops = MutableStops();
+    Stop* stop = stops.by_id[FindStopByName(name)->id];
+    stop->coordinates = coords;
+    stops.trig[stop->id] = geo::ComputeTrig(coords);
+
+    return true;
+}
+
+void TransportCatalogue::RegisterStopId(StopsData& stops, Stop* stop) {
+    if (stop->id >= stops.by_id.size()) {
+        stops.by_id.resize(stop->id + 1, nullptr);
+        stops.trig.resize(stop->id + 1);
+    }
+    stops.by_id[stop->id] = stop;
+    stops.trig[stop->id] = geo::ComputeTrig(stop->coordinates);
+}
 
-    std::string_view bus_name (ptr->bus_name);
-    routes_index_.emplace(bus_name, ptr);
+void TransportCatalogue::RebuildSecondaryIndexes() {
+    SortStopNames();
+    SortBusNames(MutableBuses());
+    BuildStopBusesIndex();
+}
 
-    for (const Stop* stop : ptr->route_stops) {
-        stop_and_buses_[stop->stop_name].insert(bus_name);
+void TransportCatalogue::SortStopNames() {
+    StopsData& stops = MutableStops();
+    const auto by_stop_name = [](const Stop* lhs, const Stop* rhs) { return lhs->stop_name < rhs->stop_name; };
+    stops.sorted.clear();
+    stops.sorted.reserve(stops.stops.size());
+    for (const Stop& stop : stops.stops) {
+        stops.sorted.push_back(&stop);
+    }
+    std::sort(stops.sorted.begin(), stops.sorted.end(), by_stop_name);
+}
+
+void TransportCatalogue::SortBusNames(BusesData& buses) {
+    const auto by_bus_name = [](const BusRoute* lhs, const BusRoute* rhs) { return lhs->bus_name < rhs->bus_name; };
+    buses.sorted.clear();
+    buses.sorted.reserve(buses.routes.size());
+    for (size_t number = 0; number < buses.routes.size(); ++number) {
+        if (!IsBusRemoved(buses, number)) {
+            buses.sorted.push_back(&buses.routes[number]);
+        }
+    }
+    std::sort(buses.sorted.begin(), buses.sorted.end(), by_bus_name);
+}
+
+bool TransportCatalogue::RestoreNameIndexes(const tc_serialize::NameIndex& index_pb) {
+    StopsData& stops = MutableStops();
+    BusesData& buses = MutableBuses();
+    if (static_cast<size_t>(index_pb.sorted_stop_ids_size()) != stops.stops.size()
+        || static_cast<size_t>(index_pb.sorted_route_numbers_size()) != buses.routes.size()) {
+        return false;
+    }
+
+    stops.sorted.clear();
+    stops.sorted.reserve(stops.stops.size());
+    for (const uint32_t stop_id : index_pb.sorted_stop_ids()) {
+        const Stop* stop = GetStopById(stop_id);
+        if (stop == nullptr || (!stops.sorted.empty() && !(stops.sorted.back()->stop_name < stop->stop_name))) {
+            return false;
+        }
+        stops.sorted.push_back(stop);
+    }
+
+    buses.sorted.clear();
+    buses.sorted.reserve(buses.routes.size());
+    for (const uint32_t route_number : index_pb.sorted_route_numbers()) {
+        if (route_number >= buses.routes.size()) {
+            return false;
+        }
+        const BusRoute* route = &buses.routes[route_number];
+        if (!buses.sorted.empty() && !(buses.sorted.back()->bus_name < route->bus_name)) {
+            return false;
+        }
+        buses.sorted.push_back(route);
     }
 
     return true;
 }
 
+void TransportCatalogue::BuildStopBusesIndex() {
+    BuildStopBusesIndex(MutableBuses(), stops_->by_id.size());
+}
+
+void TransportCatalogue::BuildStopBusesIndex(BusesData& buses, size_t stop_ids) {
+    // CSR stop -> buses index with a counting sort. Buses are visited in name order,
+    // so every stop range comes out sorted by bus name. The ranges are built without slack.
+    const std::vector<const BusRoute*>& sorted_routes = buses.sorted;
+    std::vector<uint32_t> last_bus_of_stop(stop_ids, 0);
+    buses.stop_buses_ranges.assign(stop_ids, StopBusesRange{});
+    for (uint32_t bus_i = 0; bus_i < sorted_routes.size(); ++bus_i) {
+        for (const Stop* stop : sorted_routes[bus_i]->route_stops) {
+            if (last_bus_of_stop[stop->id] == bus_i + 1) continue; // the stop is repeated in the route
+            last_bus_of_stop[stop->id] = bus_i + 1;
+            ++buses.stop_buses_ranges[stop->id].capacity;
+        }
+    }
+    uint32_t first = 0;
+    for (StopBusesRange& range : buses.stop_buses_ranges) {
+        range.first = first;
+        first += range.capacity;
+    }
+
+    buses.stop_buses.assign(first, nullptr);
+    buses.stop_buses_unused = 0;
+    std::fill(last_bus_of_stop.begin(), last_bus_of_stop.end(), 0);
+    for (uint32_t bus_i = 0; bus_i < sorted_routes.size(); ++bus_i) {
+        for (const Stop* stop : sorted_routes[bus_i]->route_stops) {
+            if (last_bus_of_stop[stop->id] == bus_i + 1) continue;
+            last_bus_of_stop[stop->id] = bus_i + 1;
+            StopBusesRange& range = buses.stop_buses_ranges[stop->id];
+            buses.stop_buses[range.first + range.size++] = sorted_routes[bus_i];
+        }
+    }
+}
+
+std::vector<uint32_t> TransportCatalogue::UniqueStopIds(const BusRoute* bus) {
+    std::vector<uint32_t> stop_ids;
+    stop_ids.reserve(bus->route_stops.size());
+    for (const Stop* stop : bus->route_stops) {
+        stop_ids.push_back(stop->id);
+    }
+    std::sort(stop_ids.begin(), stop_ids.end());
+    stop_ids.erase(std::unique(stop_ids.begin(), stop_ids.end()), stop_ids.end());
+
+    return stop_ids;
+}
+
+void TransportCatalogue::AddBusToStopsIndex(const BusRoute* bus) {
+    BusesData& buses = MutableBuses();
+    std::vector<const BusRoute*>& stop_buses = buses.stop_buses;
+    // stops added after the index was built get their empty ranges now
+    if (buses.stop_buses_ranges.size() < stops_->by_id.size()) {
+        buses.stop_buses_ranges.resize(stops_->by_id.size());
+    }
+
+    // only the ranges of the bus stops are touched
+    for (const uint32_t id : UniqueStopIds(bus)) {
+        StopBusesRange& range = buses.stop_buses_ranges[id];
+        if (range.size == range.capacity) {
+            // a full range moves to the end with twice the room, its old place is left unused
+            const uint32_t first = static_cast<uint32_t>(stop_buses.size());
+            const uint32_t capacity = std::max(MIN_STOP_BUSES_CAPACITY, range.capacity * 2);
+            stop_buses.resize(stop_buses.size() + capacity, nullptr);
+            std::copy_n(stop_buses.begin() + range.first, range.size, stop_buses.begin() + first);
+            buses.stop_buses_unused += range.capacity;
+            range.first = first;
+            range.capacity = capacity;
+        }
+
+        const auto begin = stop_buses.begin() + range.first;
+        const auto end = begin + range.size;
+        const auto pos = std::lower_bound(begin, end, bus->bus_name,
+                                          [](const BusRoute* lhs, std::string_view rhs) { return lhs->bus_name < rhs; });
+        std::copy_backward(pos, end, end + 1);
+        *pos = bus;
+        ++range.size;
+    }
+
+    // the moved ranges have left more unused slots than used ones, the index is built anew
+    if (buses.stop_buses_unused > stop_buses.size() / 2) {
+        BuildStopBusesIndex();
+    }
+}
+
+void TransportCatalogue::RemoveBusFromStopsIndex(const BusRoute* bus) {
+    BusesData& buses = MutableBuses();
+    // only the ranges of the bus stops are touched, the freed slot stays with the range
+    for (const uint32_t id : UniqueStopIds(bus)) {
+        if (id >= buses.stop_buses_ranges.size()) continue;
+        StopBusesRange& range = buses.stop_buses_ranges[id];
+        const auto begin = buses.stop_buses.begin() + range.first;
+        const auto end = begin + range.size;
+        const auto pos = std::find(begin, end, bus);
+        if (pos == end) continue;
+        std::copy(pos + 1, end, pos);
+        --range.size;
+    }
+}
+
 const BusRoute& TransportCatalogue::FindBus(std::string_view name) const {
-    const auto iter = routes_index_.find(name);
-    if (iter == routes_index_.end()) return EMPTY_BUS_ROUTE;
+    const BusRoute* route = FindBusByName(name);
+    if (route == nullptr) return EMPTY_BUS_ROUTE;
 
-    return *iter->second;
+    return *route;
 }
 
 BusInfo TransportCatalogue::GetBusInfo(std::string_view bus_name) const {
     BusInfo result;
     result.type = RouteType::NOT_SET;
 
-    auto iter = routes_index_.find(bus_name);
-    if (iter == routes_index_.end()) return result;
+    const BusRoute* route_ptr = FindBusByName(bus_name);
+    if (route_ptr == nullptr) return result;
 
-    const BusRoute& route = *iter->second;
+    const BusRoute& route = *route_ptr;
 
-    std::set<const Stop*> unique_stops(route.route_stops.begin(), route.route_stops.end());
-    result.unique_stops = unique_stops.size();
+    // the buffers of the thread are reused, a request allocates nothing once they have grown
+    BusInfoScratch& scratch = GetBusInfoScratch();
+    std::vector<uint32_t>& unique_stops = scratch.stop_ids;
+    unique_stops.clear();
+    for (const Stop* stop : route.route_stops) {
+        unique_stops.push_back(stop->id);
+    }
+    std::sort(unique_stops.begin(), unique_stops.end());
+    result.unique_stops = std::unique(unique_stops.begin(), unique_stops.end()) - unique_stops.begin();
+
+    // the shortest distances by the straight line, all segments at once: segment i goes
+    // from point i to point i + 1, so one array of the route points serves both ends
+    const size_t segments = route.route_stops.empty() ? 0 : route.route_stops.size() - 1;
+    std::vector<geo::CoordinatesTrig>& points = scratch.points;
+    points.clear();
+    for (const Stop* stop : route.route_stops) {
+        points.push_back(stops_->trig[stop->id]);
+    }
+    std::vector<double>& geo_distances = scratch.distances;
+    geo_distances.resize(segments);
+    geo::ComputeDistances(points.data(), points.data() + 1, segments, geo_distances.data());
 
     double length_geo = 0.0;
     size_t length_meters = 0;
-    for(auto first = route.route_stops.begin(); first != route.route_stops.end(); ++first) {
-        auto second = std::next(first);
-        if (second == route.route_stops.end()) break;
-
-        // compute the shortest distance by the straight line
-        length_geo += ComputeDistance((**first).coordinates, (**second).coordinates);
+    for (size_t i = 0; i < segments; ++i) {
+        length_geo += geo_distances[i];
 
         // compute the road length
-        length_meters += GetDistanceBetweenStops((**first).stop_name, (**second).stop_name);
+        const Stop* first = route.route_stops[i];
+        const Stop* second = route.route_stops[i + 1];
+        length_meters += GetDistance(first, second);
         // if it is a way and back route, add the back distance, which may be different from direct distance
         if (route.type == RouteType::RETURN_ROUTE) {
-            length_meters += GetDistanceBetweenStops((**second).stop_name, (**first).stop_name);
+            length_meters += GetDistance(second, first);
         }
     }
 
@@ -102,85 +627,117 @@ BusInfo TransportCatalogue::GetBusInfo(std::string_view bus_name) const {
     return result;
 }
 
-const std::set<std::string_view>& TransportCatalogue::GetBusesForStop(std::string_view stop) const {
-    const auto iter = stop_and_buses_.find(stop);
+TransportCatalogue::BusesRange TransportCatalogue::GetBusesForStop(std::string_view stop) const {
+    const Stop* stop_ptr = FindStopByName(stop);
 
-    if (iter == stop_and_buses_.end()) {
-        return EMPTY_BUS_ROUTE_SET;
+    if (stop_ptr == nullptr) {
+        return {buses_->stop_buses.end(), buses_->stop_buses.end()};
     }
 
-    return iter->second;
+    return GetBusesForStop(stop_ptr->id);
+}
+
+TransportCatalogue::BusesRange TransportCatalogue::GetBusesForStop(uint32_t stop_id) const {
+    const BusesData& buses = *buses_;
+    if (stop_id >= buses.stop_buses_ranges.size()) {
+        return {buses.stop_buses.end(), buses.stop_buses.end()};
+    }
+
+    const StopBusesRange& range = buses.stop_buses_ranges[stop_id];
+    return {buses.stop_buses.begin() + range.first, buses.stop_buses.begin() + range.first + range.size};
 }
 
 bool TransportCatalogue::SetDistanceBetweenStops(std::string_view stop, std::string_view other_stop, int dist) {
-    auto iter_stop = stops_index_.find(stop);
-    auto iter_other = stops_index_.find(other_stop);
-    if (iter_stop == stops_index_.end() || iter_other == stops_index_.end()) return false; // one of stops is not present in the catalogue
+    return SetDistance(stop, other_stop, dist, false);
+}
 
+bool TransportCatalogue::UpdateDistance(std::string_view stop, std::string_view other_stop, int dist) {
+    return SetDistance(stop, other_stop, dist, true);
+}
+
+bool TransportCatalogue::SetDistance(std::string_view stop, std::string_view other_stop, int dist, bool replace_implied) {
+    const Stop* stop_ptr = FindStopByName(stop);
+    const Stop* other_ptr = FindStopByName(other_stop);
+    if (stop_ptr == nullptr || other_ptr == nullptr) return false; // one of stops is not present in the catalogue
+
+    DistancesIndex& distances = MutableDistances();
+    ++routing_revision_;
     // insert direct pair without any check. it is either first insert or value substitute.
-    StopsPointers direct {};
-    direct.stop = iter_stop->second;
-    direct.other = iter_other->second;
-    stops_distance_index_[direct] = dist;
-
-    StopsPointers reverse {};
-    reverse.stop = direct.other;
-    reverse.other = direct.stop;
-    // for the reverse pair, let's check if it already exists
-    auto iter_rev = stops_distance_index_.find(reverse);
-    if (iter_rev == stops_distance_index_.end()) {
-        // insert the reverse pair if it does not exist
-        // if exists, it means that the distance might be different for the direct and reverse
-        stops_distance_index_[reverse] = dist;
+    distances[StopIdsPair{stop_ptr->id, other_ptr->id}] = PairDistance{dist, false};
+
+    // a stated reverse distance may differ from the direct one and stays as it is
+    const auto [iter_rev, inserted] = distances.emplace(StopIdsPair{other_ptr->id, stop_ptr->id}, PairDistance{dist, true});
+    if (!inserted && replace_implied && iter_rev->second.implied) {
+        iter_rev->second.meters = dist;
     }
 
     return true;
 }
 
 int TransportCatalogue::GetDistanceBetweenStops(std::string_view stop, std::string_view other_stop) const {
-    const auto iter_stop = stops_index_.find(stop);
-    const auto iter_other = stops_index_.find(other_stop);
-    if (iter_stop == stops_index_.end() || iter_other == stops_index_.end()) return -1;
+    const Stop* stop_ptr = FindStopByName(stop);
+    const Stop* other_ptr = FindStopByName(other_stop);
+    if (stop_ptr == nullptr || other_ptr == nullptr) return -1;
 
-    StopsPointers direct {};
-    direct.stop = iter_stop->second;
-    direct.other = iter_other->second;
+    return GetDistance(stop_ptr, other_ptr);
+}
 
-    auto iter_dist = stops_distance_index_.find(direct);
-    if (iter_dist == stops_distance_index_.end()) return -1;
+int TransportCatalogue::GetDistance(const Stop* stop, const Stop* other_stop) const {
+    auto iter_dist = distances_->find(StopIdsPair{stop->id, other_stop->id});
+    if (iter_dist == distances_->end()) return -1;
 
-    return iter_dist->second;
+    return iter_dist->second.meters;
 }
 
-const std::map<std::string_view, const BusRoute*> TransportCatalogue::GetAllRoutesIndex() const {
-    std::map<std::string_view, const BusRoute*>  result(routes_index_.begin(), routes_index_.end());
-    return result;
+TransportCatalogue::RoutesRange TransportCatalogue::GetAllRoutesIndex() const {
+    return ranges::AsRange(buses_->sorted);
 }
 
-const std::map<std::string_view, const Stop *> TransportCatalogue::GetAllStopsIndex() const {
-    std::map<std::string_view, const Stop*> result(stops_index_.begin(), stops_index_.end());
-    return result;
+TransportCatalogue::StopsRange TransportCatalogue::GetAllStopsIndex() const {
+    return ranges::AsRange(stops_->sorted);
+}
+
+namespace {
+
+// Range of names in the sorted vector that start with the prefix: names below the prefix go
+// first, then the names with the prefix, then the rest
+template <typename Sorted, typename GetName>
+auto PrefixRange(const Sorted& sorted, std::string_view prefix, GetName get_name) {
+    const auto first = std::partition_point(sorted.begin(), sorted.end(), [&](const auto* item) {
+        return std::string_view(get_name(item)).substr(0, prefix.size()) < prefix;
+    });
+    const auto last = std::partition_point(first, sorted.end(), [&](const auto* item) {
+        return std::string_view(get_name(item)).substr(0, prefix.size()) == prefix;
+    });
+    return ranges::Range{first, last};
+}
+
+} // namespace
+
+TransportCatalogue::StopsRange TransportCatalogue::FindStopsByPrefix(std::string_view prefix) const {
+    return PrefixRange(stops_->sorted, prefix, [](const Stop* stop) -> const std::string& { return stop->stop_name; });
+}
+
+TransportCatalogue::RoutesRange TransportCatalogue::FindRoutesByPrefix(std::string_view prefix) const {
+    return PrefixRange(buses_->sorted, prefix, [](const BusRoute* route) -> const std::string& { return route->bus_name; });
 }
 
-const std::unordered_map<std::string_view, const Stop *>&
-TransportCatalogue::RawStopsIndex() const {
-    return stops_index_;
+const TransportCatalogue::DistancesIndex& TransportCatalogue::RawDistancesIndex() const {
+    return *distances_;
 }
 
-const std::unordered_map<StopsPointers, int, StopsPointers, StopsPointers>&
-TransportCatalogue::RawDistancesIndex() const {
-    return stops_distance_index_;
+uint64_t TransportCatalogue::GetRoutingRevision() const {
+    return routing_revision_;
 }
 
-const std::unordered_map<std::string_view, std::set<std::string_view>> &
-TransportCatalogue::GetStopAndBuses() const {
-    return stop_and_buses_;
+bool TransportCatalogue::SharesStopsWith(const TransportCatalogue& other) const {
+    return stops_ == other.stops_;
 }
 
 size_t TransportCatalogue::GetNumberOfStopsOnAllRoutes() const {
     size_t result = 0;
 
-    for (const auto& [bus, route] : routes_index_) {
+    for (const BusRoute* route : buses_->sorted) {
         result += route->route_stops.size();
         if (route->type == RouteType::CIRCLE_ROUTE) {
             --result;
@@ -193,24 +750,32 @@ size_t TransportCatalogue::GetNumberOfStopsOnAllRoutes() const {
 void TransportCatalogue::SaveTo(tc_serialize::TransportCatalogue& t_cat) const {
     // Preparing  Stops
     tc_serialize::StopsList st_list;
-    for (const auto [_, stop_ptr] : stop_id_name_index_ ) {
-        *st_list.add_all_stops() = std::move(SerializeStop(*stop_ptr));
+    for (const Stop& stop : stops_->stops) {
+        *st_list.add_all_stops() = std::move(SerializeStop(stop));
     }
     //*t_cat.mutable_stops() = st_list;
     *(t_cat.mutable_base_settings()->mutable_stops_list()) = std::move(st_list);
 
     // Preparing stop distances
     tc_serialize::StopDistanceIndex stop_distances;
-    for (const auto [stop_ptrs, distance] : stops_distance_index_) {
+    for (const auto& [stop_ids, distance] : *distances_) {
         *stop_distances.add_all_stops_distance_index() = std::move(
-                SerializeDistance(stop_ptrs.stop->id, stop_ptrs.other->id, distance));
+                SerializeDistance(stop_ids.stop, stop_ids.other, distance.meters, distance.implied));
     }
     //*t_cat.mutable_index() = stop_distances;
     *(t_cat.mutable_base_settings()->mutable_stop_dist_index()) = std::move(stop_distances);
 
-    // Preparing bus routes
+    // Preparing bus routes, removed ones are left out and the rest is numbered anew
+    std::vector<const BusRoute*> saved_routes;
+    saved_routes.reserve(buses_->routes.size());
+    for (size_t number = 0; number < buses_->routes.size(); ++number) {
+        if (!IsBusRemoved(number)) {
+            saved_routes.push_back(&buses_->routes[number]);
+        }
+    }
     tc_serialize::AllRoutesList routes_list;
-    for (const BusRoute& route : bus_routes_) {
+    for (const BusRoute* route_ptr : saved_routes) {
+        const BusRoute& route = *route_ptr;
         tc_serialize::BusRoute br_out;
         br_out.set_bus_name(route.bus_name);
         int32_t rt = 0;
@@ -229,27 +794,66 @@ void TransportCatalogue::SaveTo(tc_serialize::TransportCatalogue& t_cat) const {
     }
     //*t_cat.mutable_routes() = routes_list;
     *(t_cat.mutable_base_settings()->mutable_all_routes_list()) = std::move(routes_list);
+
+    // Preparing the name order, buses are referred to by their number in the routes list
+    std::unordered_map<const BusRoute*, uint32_t> route_numbers;
+    route_numbers.reserve(saved_routes.size());
+    for (const BusRoute* route : saved_routes) {
+        route_numbers.emplace(route, static_cast<uint32_t>(route_numbers.size()));
+    }
+    tc_serialize::NameIndex name_index;
+    for (const Stop* stop : stops_->sorted) {
+        name_index.add_sorted_stop_ids(stop->id);
+    }
+    for (const BusRoute* route : buses_->sorted) {
+        name_index.add_sorted_route_numbers(route_numbers.at(route));
+    }
+    *(t_cat.mutable_base_settings()->mutable_name_index()) = std::move(name_index);
+
+    // Preparing perfect hashes of all names
+    std::vector<NameIndex::Entry> stop_entries;
+    stop_entries.reserve(stops_->stops.size());
+    for (const Stop& stop : stops_->stops) {
+        stop_entries.emplace_back(stop.stop_name, stop.id);
+    }
+    NameIndex(stop_entries).SaveTo(*t_cat.mutable_base_settings()->mutable_stop_names());
+    std::vector<NameIndex::Entry> bus_entries;
+    bus_entries.reserve(saved_routes.size());
+    for (const BusRoute* route : saved_routes) {
+        bus_entries.emplace_back(route->bus_name, static_cast<uint32_t>(bus_entries.size()));
+    }
+    NameIndex(bus_entries).SaveTo(*t_cat.mutable_base_settings()->mutable_bus_names());
 }
 
 
 bool TransportCatalogue::RestoreFrom(tc_serialize::TransportCatalogue& t_cat) {
     // Restore stops
-    tc_serialize::StopsList st_list = t_cat.base_settings().stops_list();
+    // Names are looked up through the perfect hashes saved in the base, no hash table is filled
+    ++routing_revision_;
+    StopsData& stops = MutableStops();
+    stops.names = NameIndex(t_cat.base_settings().stop_names());
+    MutableBuses().names = NameIndex(t_cat.base_settings().bus_names());
+
+    const tc_serialize::StopsList& st_list = t_cat.base_settings().stops_list();
+    stops.by_id.reserve(st_list.all_stops_size() + 1);
     for (int i = 0; i < st_list.all_stops_size(); ++i) {
-        AddStop(DeserializeStop(st_list.all_stops(i)));
+        EmplaceStop(DeserializeStop(st_list.all_stops(i)));
     }
 
-    // Restores distances between stops
-    tc_serialize::StopDistanceIndex stops_distances = t_cat.base_settings().stop_dist_index();
+    // Restores distances between stops, the index is saved with the reverse pairs already
+    const tc_serialize::StopDistanceIndex& stops_distances = t_cat.base_settings().stop_dist_index();
+    DistancesIndex& distances = MutableDistances();
+    distances.reserve(stops_distances.all_stops_distance_index_size());
     for (int i = 0; i < stops_distances.all_stops_distance_index_size(); ++i) {
         const tc_serialize::DistanceBetweenStops& dist = stops_distances.all_stops_distance_index(i);
-        std::string_view from = GetStopNameById(dist.from_id());
-        std::string_view to = GetStopNameById(dist.to_id());
-        SetDistanceBetweenStops(from, to, dist.distance());
+        if (GetStopById(dist.from_id()) == nullptr || GetStopById(dist.to_id()) == nullptr) {
+            return false;
+        }
+        distances[StopIdsPair{dist.from_id(), dist.to_id()}] = PairDistance{static_cast<int>(dist.distance()), dist.implied()};
     }
 
     // Restore bus routes
-    tc_serialize::AllRoutesList all_routes = t_cat.base_settings().all_routes_list();
+    const tc_serialize::AllRoutesList& all_routes = t_cat.base_settings().all_routes_list();
     for (int i = 0; i < all_routes.routes_list_size(); ++i) {
         const tc_serialize::BusRoute& route_in = all_routes.routes_list(i);
         BusRoute bus_out;
@@ -263,15 +867,22 @@ bool TransportCatalogue::RestoreFrom(tc_serialize::TransportCatalogue& t_cat) {
         }
         bus_out.route_stops.reserve(route_in.stop_ids_size());
         for (int j = 0; j < route_in.stop_ids_size(); ++j) {
-            const std::string_view stop_name = GetStopNameById(route_in.stop_ids(j));
-            const auto [result, stop_const_ref] = FindStop(stop_name);
-            if (!result) {
+            const uint32_t stop_id = route_in.stop_ids(j);
+            const Stop* stop = GetStopById(stop_id);
+            if (stop == nullptr) {
                 return false;
             }
-            bus_out.route_stops.push_back(&stop_const_ref);
+            bus_out.route_stops.push_back(stop);
         }
-        AddBus(bus_out);
+        EmplaceBus(std::move(bus_out));
+    }
+
+    // the sorted name order is saved in the base, older bases without it are sorted here
+    if (!RestoreNameIndexes(t_cat.base_settings().name_index())) {
+        SortStopNames();
+        SortBusNames(MutableBuses());
     }
+    BuildStopBusesIndex();
 
     return true;
 }
@@ -279,21 +890,60 @@ bool TransportCatalogue::RestoreFrom(tc_serialize::TransportCatalogue& t_cat) {
 
 
 uint32_t TransportCatalogue::GetStopId(const std::string_view stop_name) const {
-    auto iter = stops_index_.find(stop_name);
-    if (iter == stops_index_.end()) {
+    const Stop* stop = FindStopByName(stop_name);
+    if (stop == nullptr) {
         return 0;
     }
 
-    return iter->second->id;
+    return stop->id;
 }
 
 const std::string_view TransportCatalogue::GetStopNameById(uint32_t stop_id) const {
-    auto iter = stop_id_name_index_.find(stop_id);
-    if (iter == stop_id_name_index_.end()) {
+    const Stop* stop = GetStopById(stop_id);
+    if (stop == nullptr) {
         return {};
     }
 
-    return {iter->second->stop_name};
+    return {stop->stop_name};
+}
+
+const geo::CoordinatesTrig& TransportCatalogue::GetStopTrig(uint32_t stop_id) const {
+    return stops_->trig.at(stop_id);
+}
+
+const Stop* TransportCatalogue::GetStopById(uint32_t stop_id) const {
+    if (stop_id >= stops_->by_id.size()) {
+        return nullptr;
+    }
+
+    return stops_->by_id[stop_id];
+}
+
+memory::MemoryUsage TransportCatalogue::MemoryUsage() const {
+    using memory::BytesOf;
+    memory::MemoryUsage usage;
+
+    // the data shared with other copies is counted in full
+    const StopsData& stops = *stops_;
+    size_t stops_bytes = BytesOf(stops.stops);
+    for (const Stop& stop : stops.stops) {
+        stops_bytes += BytesOf(stop.stop_name);
+    }
+    usage.Add("stops", stops_bytes);
+    usage.Add("stops_index", stops.names.MemoryUsage().Total() + BytesOf(stops.by_id) + BytesOf(stops.sorted));
+    usage.Add("stop_trig", BytesOf(stops.trig));
+
+    const BusesData& buses = *buses_;
+    size_t buses_bytes = BytesOf(buses.routes);
+    for (const BusRoute& bus : buses.routes) {
+        buses_bytes += BytesOf(bus.bus_name) + BytesOf(bus.route_stops);
+    }
+    usage.Add("buses", buses_bytes);
+    usage.Add("buses_index", buses.names.MemoryUsage().Total() + BytesOf(buses.sorted));
+    usage.Add("distance_index", BytesOf(*distances_));
+    usage.Add("stop_to_buses_index", BytesOf(buses.stop_buses_ranges) + BytesOf(buses.stop_buses));
+
+    return usage;
 }
 
 } // transport_catalogue namespace
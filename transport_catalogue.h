@@ -3,6 +3,7 @@
 #include <map>
 #include <set>
 #include <deque>
+#include <memory>
 #include <string>
 #include <vector>
 #include <optional>
@@ -12,6 +13,9 @@
 #include "geo.h"
 #include "domain.h"
 #include "graph.h"
+#include "ranges.h"
+#include "memory_usage.h"
+#include "name_index.h"
 #include "serialization.h"
 #include "transport_catalogue.pb.h"
 
@@ -22,61 +26,163 @@ const double MET_MIN_RATIO = 1000.00 / 60.00;
 
 
 
-struct StopsPointers {
-public:
-    const Stop* stop;
-    const Stop* other;
+// The stops of a distance by id, so the distances stay valid for copies of the stops
+struct StopIdsPair {
+    uint32_t stop;
+    uint32_t other;
 
-    size_t operator()(const StopsPointers& st_pair) const{
-        return hasher_(st_pair.stop) + 43*hasher_(st_pair.other);
+    size_t operator()(const StopIdsPair& ids) const{
+        return std::hash<uint64_t>{}(uint64_t{ids.stop} << 32 | ids.other);
     }
 
-    bool operator()(const StopsPointers& lhs, const StopsPointers& rhs) const{
+    bool operator()(const StopIdsPair& lhs, const StopIdsPair& rhs) const{
         return lhs.stop == rhs.stop && lhs.other == rhs.other;
     }
+};
 
-private:
-    std::hash<const Stop*> hasher_;
 
+// An implied distance was not stated, it was taken from the reverse pair
+struct PairDistance {
+    int meters = 0;
+    bool implied = false;
 };
 
 
 class TransportCatalogue {
 public:
+    using StopsRange = ranges::Range<std::vector<const Stop*>::const_iterator>;
+    using RoutesRange = ranges::Range<std::vector<const BusRoute*>::const_iterator>;
+    using BusesRange = RoutesRange;
+
+    using DistancesIndex = std::unordered_map<StopIdsPair, PairDistance, StopIdsPair, StopIdsPair>;
+
     TransportCatalogue() = default;
+    // The copy shares the stops, the distances and the buses with other, each of them is copied
+    // on its first change in either catalogue (copy on write). Buses refer to the stops, so the
+    // buses are copied with the stops. Removed buses are left out when the buses are copied.
+    TransportCatalogue(const TransportCatalogue& other) = default;
+    TransportCatalogue(TransportCatalogue&& other) = default;
+    TransportCatalogue& operator=(const TransportCatalogue& other) = delete;
+    TransportCatalogue& operator=(TransportCatalogue&& other) = delete;
+
     void AddStop(const std::string& name, const geo::Coordinates coords);
     void AddStop(const Stop& stop);
     std::pair<bool, const Stop&> FindStop(const std::string_view name) const;
     bool AddBus(const BusRoute& bus_route);
+    // Loads stops, distances and buses at once; returns the number of entries that were rejected
+    // (duplicates, unknown stop names). Secondary indexes are built once at the end.
+    size_t BulkLoad(std::vector<StopWithDistances>&& stops, std::vector<BusWithStopNames>&& buses);
     const BusRoute& FindBus(std::string_view name) const;
     BusInfo GetBusInfo(std::string_view bus_name) const;
-    const std::set<std::string_view>& GetBusesForStop(std::string_view stop) const;
+    BusesRange GetBusesForStop(std::string_view stop) const; // buses of a stop, sorted by bus name
+    BusesRange GetBusesForStop(uint32_t stop_id) const;
+    // Keeps the reverse distance if there is one, so a stated reverse distance is never overwritten
     bool SetDistanceBetweenStops(std::string_view stop, std::string_view other_stop, int dist);
+    // Changes a stated distance the way a rebuild would: an implied reverse distance follows it
+    bool UpdateDistance(std::string_view stop, std::string_view other_stop, int dist);
+
+    // Changes in place. The stop -> buses index is updated only for the stops of the bus.
+    // Alone, every added stop or bus and every removed bus shifts the tail of a sorted name
+    // index, O(stops) or O(buses) each, so N additions one by one cost O(N^2).
+    // Removed buses stay as tombstones until the buses are copied, the base file leaves them out.
+    // The distance between stops is changed with UpdateDistance.
+    // Between StartBatch and FinishBatch the name indexes are not kept sorted: FinishBatch sorts
+    // the additions once and merges them in, as BulkLoad does. Meanwhile GetAllStopsIndex,
+    // GetAllRoutesIndex and the prefix searches are not valid, the lookups by name are.
+    void StartBatch();
+    void FinishBatch();
+    bool RemoveBus(std::string_view name);
+    bool ReplaceBus(const BusRoute& bus_route); // adds the bus, or replaces the one with the same name
+    bool UpdateStopCoordinates(std::string_view name, geo::Coordinates coords);
     int GetDistanceBetweenStops(std::string_view stop, std::string_view other_stop) const;
-    const std::map<std::string_view, const BusRoute*> GetAllRoutesIndex() const;
-    const std::map<std::string_view, const Stop*> GetAllStopsIndex() const;
-    const std::unordered_map<std::string_view, const Stop*>& RawStopsIndex() const;
+    RoutesRange GetAllRoutesIndex() const; // all bus routes, sorted by bus name
+    StopsRange GetAllStopsIndex() const; // all stops, sorted by stop name
+    // stops and routes whose names start with the prefix, sorted by name; binary search, nothing is allocated
+    StopsRange FindStopsByPrefix(std::string_view prefix) const;
+    RoutesRange FindRoutesByPrefix(std::string_view prefix) const;
     size_t GetNumberOfStopsOnAllRoutes() const;
-    const std::unordered_map<StopsPointers, int, StopsPointers, StopsPointers>& RawDistancesIndex() const;
-    const std::unordered_map<std::string_view, std::set<std::string_view>>& GetStopAndBuses() const;
+    const DistancesIndex& RawDistancesIndex() const;
+    // Grows with every change the routing graph depends on: stops, distances and buses.
+    // A copy that has the revision of its source needs no graph of its own.
+    uint64_t GetRoutingRevision() const;
+    // The stops are the same objects, as in a copy before any stop was added or moved
+    bool SharesStopsWith(const TransportCatalogue& other) const;
 
     void SaveTo(tc_serialize::TransportCatalogue& t_cat) const;
     bool RestoreFrom(tc_serialize::TransportCatalogue& t_cat);
 
     uint32_t GetStopId(const std::string_view stop_name) const;
     const std::string_view GetStopNameById(uint32_t stop_id) const;
-private:
-    uint32_t stop_id_counter_ = 0;
-
-    std::deque<Stop> stops_;
-    std::unordered_map<std::string_view, const Stop*> stops_index_;
-    std::unordered_map<uint32_t, const Stop*> stop_id_name_index_;
+    const Stop* GetStopById(uint32_t stop_id) const;
+    const geo::CoordinatesTrig& GetStopTrig(uint32_t stop_id) const;
 
-    std::deque<BusRoute> bus_routes_;
-    std::unordered_map<std::string_view, const BusRoute*> routes_index_;
-    std::unordered_map<std::string_view, std::set<std::string_view>> stop_and_buses_;
-
-    std::unordered_map<StopsPointers, int, StopsPointers, StopsPointers> stops_distance_index_;
+    memory::MemoryUsage MemoryUsage() const;
+private:
+    struct StopsData {
+        uint32_t id_counter = 0;
+        std::deque<Stop> stops;
+        NameIndex names; // name -> stop id
+        std::vector<Stop*> by_id; // index is the stop id, id 0 is never used; the one way to change a stop
+        std::vector<geo::CoordinatesTrig> trig; // precomputed trigonometry of stop coordinates, by stop id
+        std::vector<const Stop*> sorted; // kept sorted by name on every insert
+    };
+
+    // stop -> buses index in CSR layout with slack: buses of the stop with id N are the first
+    // size slots of its range in stop_buses, sorted by bus name; the rest of the range is free
+    struct StopBusesRange {
+        uint32_t first = 0;
+        uint32_t size = 0;
+        uint32_t capacity = 0;
+    };
+
+    struct BusesData {
+        std::deque<BusRoute> routes;
+        NameIndex names; // name -> number of the bus in routes
+        std::vector<bool> removed; // by bus number, removed buses stay in routes as empty tombstones until a copy or a save
+        std::vector<const BusRoute*> sorted; // kept sorted by name on every insert
+        std::vector<StopBusesRange> stop_buses_ranges; // by stop id, stops without buses may be missing at the end
+        std::vector<const BusRoute*> stop_buses;
+        size_t stop_buses_unused = 0; // slots left behind by ranges moved to the end
+    };
+
+    // Shared with the copies of the catalogue until the first change, see Mutable*()
+    std::shared_ptr<StopsData> stops_ = std::make_shared<StopsData>();
+    std::shared_ptr<DistancesIndex> distances_ = std::make_shared<DistancesIndex>();
+    std::shared_ptr<BusesData> buses_ = std::make_shared<BusesData>();
+    uint64_t routing_revision_ = 0;
+
+    // in a batch, the sorted parts of the name indexes and the buses to take out of the sorted routes
+    bool batch_ = false;
+    size_t batch_sorted_stops_ = 0;
+    size_t batch_sorted_routes_ = 0;
+    std::vector<const BusRoute*> batch_removed_routes_;
+
+    // The data to change, copied first if another catalogue shares it. Copied stops come with
+    // buses that refer to them, so a BusesData& taken before MutableStops() is not valid after it.
+    StopsData& MutableStops();
+    DistancesIndex& MutableDistances();
+    BusesData& MutableBuses();
+    static std::shared_ptr<BusesData> CopyBuses(const BusesData& other, const StopsData& stops);
+
+    const Stop* FindStopByName(std::string_view name) const;
+    const BusRoute* FindBusByName(std::string_view name) const;
+    std::optional<uint32_t> FindBusNumber(std::string_view name) const;
+    const Stop* EmplaceStop(Stop&& stop);
+    const BusRoute* EmplaceBus(BusRoute&& bus_route);
+    void RebuildSecondaryIndexes();
+    void SortStopNames();
+    static void SortBusNames(BusesData& buses);
+    bool RestoreNameIndexes(const tc_serialize::NameIndex& index_pb);
+    void BuildStopBusesIndex();
+    static void BuildStopBusesIndex(BusesData& buses, size_t stop_ids);
+    static void RegisterStopId(StopsData& stops, Stop* stop);
+    int GetDistance(const Stop* stop, const Stop* other_stop) const;
+    bool SetDistance(std::string_view stop, std::string_view other_stop, int dist, bool replace_implied);
+    static std::vector<uint32_t> UniqueStopIds(const BusRoute* bus);
+    void AddBusToStopsIndex(const BusRoute* bus);
+    void RemoveBusFromStopsIndex(const BusRoute* bus);
+    bool IsBusRemoved(size_t number) const;
+    static bool IsBusRemoved(const BusesData& buses, size_t number);
 };
 
 
@@ -2,18 +2,17 @@
 
 
 TransportCatalogueRouterGraph::TransportCatalogueRouterGraph(const transport_catalogue::TransportCatalogue& tc, RoutingSettings rs):
-        graph::DirectedWeightedGraph<double>(tc.RawStopsIndex().size()), tc_(tc), rs_(rs) {
+        graph::DirectedWeightedGraph<double>(tc.GetAllStopsIndex().size()), tc_(tc), rs_(rs) {
 
     const auto& routes_index = tc_.GetAllRoutesIndex(); // Get all bus routes for all stops on routes
 
     // Register all stops that we have in catalogue as vertices
-    for (const auto& [stop_name, stop_ptr] : tc_.RawStopsIndex()) {
-        StopOnRoute stop {0, stop_name, {}};
+    for (const transport_catalogue::Stop* stop : tc_.GetAllStopsIndex()) {
         RegisterStop(stop);
     }
 
     // iterate for all routes
-    for (const auto& [_, bus_route] : routes_index) {
+    for (const auto bus_route : routes_index) {
         if (bus_route->type == transport_catalogue::RouteType::RETURN_ROUTE) {
             FillWithReturnRouteStops(bus_route);
         } else {
@@ -33,9 +32,9 @@ void TransportCatalogueRouterGraph::FillWithReturnRouteStops(const transport_cat
 
         const auto wait_time_at_stop = static_cast<double>(rs_.bus_wait_time);
 
-        auto from_id = GetStopVertexId((*start)->stop_name);
+        auto from_id = GetStopVertexId((*start)->id);
         for (auto first = start, second = start + 1; second != bus_route->route_stops.end(); ++first, ++second) {
-            auto to_id = GetStopVertexId((*second)->stop_name);
+            auto to_id = GetStopVertexId((*second)->id);
 
             TwoStopsLink direct_link(bus_route->bus_name, from_id, to_id, stop_distance);
             const int direct_distance = tc_.GetDistanceBetweenStops((*first)->stop_name, (*second)->stop_name);
@@ -67,9 +66,9 @@ void TransportCatalogueRouterGraph::FillWithCircleRouteStops(const transport_cat
 
         const auto wait_time_at_stop = static_cast<double>(rs_.bus_wait_time);
 
-        auto from_id = GetStopVertexId((*start)->stop_name);
+        auto from_id = GetStopVertexId((*start)->id);
         for (auto first = start, second = start + 1; second != bus_route->route_stops.end(); ++first, ++second) {
-            auto to_id = GetStopVertexId((*second)->stop_name);
+            auto to_id = GetStopVertexId((*second)->id);
 
             // make direct link and register Edge
             TwoStopsLink direct_link(bus_route->bus_name, from_id, to_id, stop_distance);
@@ -88,16 +87,18 @@ void TransportCatalogueRouterGraph::FillWithCircleRouteStops(const transport_cat
 
 
 
-graph::VertexId TransportCatalogueRouterGraph::RegisterStop(const StopOnRoute& stop) {
-    auto iter = stop_to_vertex_.find(stop);
-    if (iter != stop_to_vertex_.end()) {
-        return iter->second; // return the stop vertex number, it already exists in the map
+graph::VertexId TransportCatalogueRouterGraph::RegisterStop(const transport_catalogue::Stop* stop) {
+    if (stop->id >= stop_vertices_.size()) {
+        stop_vertices_.resize(stop->id + 1, NO_VERTEX);
+    }
+    if (stop_vertices_[stop->id] != NO_VERTEX) {
+        return stop_vertices_[stop->id]; // return the stop vertex number, it is already registered
     }
 
     auto result = vertex_id_count_;
 
-    stop_to_vertex_[stop] = vertex_id_count_;
-    vertex_to_stop_[vertex_id_count_] = stop;
+    stop_vertices_[stop->id] = vertex_id_count_;
+    vertex_to_stop_.emplace_back(0, stop->stop_name, std::string_view {});
     ++vertex_id_count_;
 
     return result;
@@ -130,16 +131,22 @@ double TransportCatalogueRouterGraph::CalculateTimeForDistance(int distance) con
 }
 
 graph::VertexId TransportCatalogueRouterGraph::GetStopVertexId(std::string_view stop_name) const {
-    StopOnRoute stop{0, stop_name, {}};
-    auto iter = stop_to_vertex_.find(stop);
-
-    if (iter != stop_to_vertex_.end()) {
-        return iter->second; // return the stop vertex number, if it exists in the map
+    const uint32_t stop_id = tc_.GetStopId(stop_name);
+    if (stop_id != 0 && stop_id < stop_vertices_.size() && stop_vertices_[stop_id] != NO_VERTEX) {
+        return stop_vertices_[stop_id];
     }
 
     throw std::logic_error("Error, no stop name: " + std::string (stop_name));
 }
 
+graph::VertexId TransportCatalogueRouterGraph::GetStopVertexId(uint32_t stop_id) const {
+    if (stop_id < stop_vertices_.size() && stop_vertices_[stop_id] != NO_VERTEX) {
+        return stop_vertices_[stop_id];
+    }
+
+    throw std::logic_error("Error, no stop id: " + std::to_string(stop_id));
+}
+
 const TransportCatalogueRouterGraph::StopOnRoute& TransportCatalogueRouterGraph::GetStopById(graph::VertexId id) const {
     return vertex_to_stop_.at(id);
 }
@@ -167,6 +174,21 @@ std::optional<graph::Router<double>::RouteInfo> TransportCatalogueRouterGraph::B
     return router_ptr_->BuildRoute(from_id, to_id);
 }
 
+memory::MemoryUsage TransportCatalogueRouterGraph::MemoryUsage() const {
+    using memory::BytesOf;
+    memory::MemoryUsage usage = DirectedWeightedGraph::MemoryUsage();
+    usage.Add("vertex_maps", BytesOf(stop_vertices_) + BytesOf(vertex_to_stop_));
+    usage.Add("link_maps", BytesOf(stoplink_to_edge_) + BytesOf(edge_to_stoplink_));
+
+    return usage;
+}
+
+memory::MemoryUsage TransportCatalogueRouterGraph::RouterMemoryUsage() const {
+    if (!router_ptr_) return {};
+
+    return router_ptr_->MemoryUsage();
+}
+
 TransportCatalogueRouterGraph::TransportCatalogueRouterGraph(const transport_catalogue::TransportCatalogue &tc, RoutingSettings rs,
     const tc_serialize::TransportCatalogue &tc_pbuf) : tc_(tc), rs_(rs) {
     RestoreFrom(tc_pbuf);
@@ -178,9 +200,9 @@ bool TransportCatalogueRouterGraph::SaveTo(tc_serialize::TransportCatalogue& tc_
     tc_serialize::TCGraphRouter out;
 
     // Saving fields of TransportCatalogueRouterGraph
-    // stop_to_vertex_ & vertex_to_stop_ saving - they have same pair
-    for (const auto& [stop, vertex] : stop_to_vertex_) {
-        *out.add_tc_router_stops_() = std::move(SerializeStopOnRoute(stop, vertex));
+    // vertex_to_stop_ saving, stop_vertices_ is restored from the same pairs
+    for (graph::VertexId vertex = 0; vertex < vertex_to_stop_.size(); ++vertex) {
+        *out.add_tc_router_stops_() = std::move(SerializeStopOnRoute(vertex_to_stop_[vertex], vertex));
     }
     // stoplink_to_edge_ & edge_to_stoplink_ saving - they have same pair
     for (const auto& [stoplink, edge] : stoplink_to_edge_) {
@@ -212,13 +234,20 @@ bool TransportCatalogueRouterGraph::SaveTo(tc_serialize::TransportCatalogue& tc_
 
 bool TransportCatalogueRouterGraph::RestoreFrom(const tc_serialize::TransportCatalogue &tc_in) {
     // Restoring fields of TransportCatalogueRouterGraph
-    // stop_to_vertex_ & vertex_to_stop_ saving - they have same pair
+    // stop_vertices_ & vertex_to_stop_ restoring - they have same pair, both are plain arrays
     const auto& data_from = tc_in.router_settings().tc_graph_router();
+    vertex_to_stop_.resize(data_from.tc_router_stops__size());
     for (int i = 0; i < data_from.tc_router_stops__size(); ++i) {
-        StopOnRoute stop = DeserializeStopOnRoute(data_from.tc_router_stops_(i));
-        graph::VertexId vertex_id = data_from.tc_router_stops_(i).vertex_id();
-        stop_to_vertex_[stop] = vertex_id;
-        vertex_to_stop_[vertex_id] = stop;
+        const tc_serialize::StopOnRoutePB& stop_pb = data_from.tc_router_stops_(i);
+        const graph::VertexId vertex_id = stop_pb.vertex_id();
+        if (vertex_id >= vertex_to_stop_.size()) {
+            return false;
+        }
+        if (stop_pb.stop_id() >= stop_vertices_.size()) {
+            stop_vertices_.resize(stop_pb.stop_id() + 1, NO_VERTEX);
+        }
+        stop_vertices_[stop_pb.stop_id()] = vertex_id;
+        vertex_to_stop_[vertex_id] = DeserializeStopOnRoute(stop_pb);
     }
     // stoplink_to_edge_ & edge_to_stoplink_ saving - they have same pair
     for (int i = 0; i < data_from.tc_router_links_size(); ++i) {
@@ -266,9 +295,7 @@ TransportCatalogueRouterGraph::StopOnRoute
 TransportCatalogueRouterGraph::DeserializeStopOnRoute(const tc_serialize::StopOnRoutePB &stop) {
     TransportCatalogueRouterGraph::StopOnRoute result;
 
-    auto st_name = tc_.GetStopNameById(stop.stop_id());
-    const auto& [found, st_ref] = tc_.FindStop(st_name);
-    result.stop_name = st_ref.stop_name;
+    result.stop_name = tc_.GetStopNameById(stop.stop_id());
 
     result.bus_name = stop.bus_name();
     result.stop_number = stop.stop_number();
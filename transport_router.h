@@ -2,6 +2,7 @@
 #include "transport_catalogue.h"
 #include "transport_catalogue.pb.h"
 #include "router.h"
+#include <limits>
 #include <memory>
 
 
@@ -73,23 +74,30 @@ public:
     const TwoStopsLink& GetLinkById(graph::EdgeId id) const;
     double GetBusWaitingTime() const;
 
+    // edges and incidence lists of the graph plus the vertex and link maps; the router is reported separately
+    memory::MemoryUsage MemoryUsage() const;
+    memory::MemoryUsage RouterMemoryUsage() const;
+
 private:
+    static constexpr graph::VertexId NO_VERTEX = std::numeric_limits<graph::VertexId>::max();
+
     const transport_catalogue::TransportCatalogue& tc_;
     RoutingSettings rs_;
     graph::EdgeId edge_count_ = 0;
     std::unique_ptr<graph::Router<double>> router_ptr_;
 
-    std::unordered_map<StopOnRoute, graph::VertexId , StopOnRoute, StopOnRoute> stop_to_vertex_;
-    std::unordered_map<size_t , StopOnRoute> vertex_to_stop_;
+    std::vector<graph::VertexId> stop_vertices_; // vertex of the stop, by stop id
+    std::vector<StopOnRoute> vertex_to_stop_; // by vertex id
     graph::VertexId vertex_id_count_ = 0;
 
     std::unordered_map<TwoStopsLink, graph::EdgeId, TwoStopsLink, TwoStopsLink> stoplink_to_edge_;
     std::unordered_map<graph::EdgeId, TwoStopsLink> edge_to_stoplink_;
 
-    graph::VertexId RegisterStop(const StopOnRoute& stop);
+    graph::VertexId RegisterStop(const transport_catalogue::Stop* stop);
     graph::EdgeId StoreLink(const TwoStopsLink& link, graph::EdgeId edge);
     std::optional<graph::EdgeId> CheckLink(const TwoStopsLink& link) const;
     graph::VertexId GetStopVertexId(std::string_view stop_name) const;
+    graph::VertexId GetStopVertexId(uint32_t stop_id) const;
 
     void FillWithReturnRouteStops(const transport_catalogue::BusRoute* bus_route);
     void FillWithCircleRouteStops(const transport_catalogue::BusRoute* bus_route);